@@ -59,10 +59,10 @@ static void AllocatorDestroy(void* pthis)
 	mempool_block* Next = NULL,*Cur = NULL;
 
 	/* 逐个释放每个链表的资源 */
-	for (i = 0; i < allocator->max_index; i++) {
+	for (i = 0; i < allocator->m_max_index; i++) {
 		Next = allocator->free[i];
 
-		while ((NULL != Next->next) && (Next != NULL)) {
+		while ((Next != NULL) && (NULL != Next->next)) {
 			/* 释放链表上的内存块 */
 			Cur = Next;
 			Next = Next->next;
@@ -14,6 +14,7 @@
 */
 
 //内部头文件
+#define _GNU_SOURCE
 /* #include "log.h" */
 #include <stdio.h>
 #include <stdint.h>
@@ -28,45 +29,107 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
+#include <poll.h>
+#include <limits.h>
+#include <pthread.h>
+#include "logBinary.h"
+#include "logUring.h"
+#include "logArchive.h"
+#include "logIndex.h"
+#include "../MessageQueue/shmQueue.h"
 
 //内部定义
 #define LOG_FOLDER_NAME     "log/"              /* 日志目录 */
 #define LOG_FILE_NAME       "log"               /* 文件名称 */
-#define MAX_LOG_SIZE        (2 * 1024 * 1024)   /* 每个文件大小 */
-#define MAX_LOG_NUM         5                   /* 文件个数 */
+#define MAX_LOG_SIZE        (2 * 1024 * 1024)   /* 默认每个文件大小 */
+#define MAX_LOG_NUM         50                  /* 默认保留的滚动文件个数 */
+#define MAX_LOG_TOTAL       (64 * 1024 * 1024)  /* 默认滚动文件总大小上限 */
+#define LOG_GZIP_LEVEL      6                   /* 默认滚动文件压缩级别 */
 #define MAX_BUF_LEN         65535               /* 通用最大buf长度 */
-#define MAX_TIME_LEN        32                  /* 时间长度 */
-#define MAX_MESSAGE_NUMBER  100                 /* 最大消息个数 */
-#define ENABLE_WRITE_FLAG   1                   /* 写文件标志 */
+#define LOG_TIME_SEC_LEN    21                  /* "[YYYY-MM-DD HH:MM:SS."长度 */
 #define MAX_STRING_SIZE     4096                /* 日志最大字符长度 */
 #define SOFTWARE_VERSION    "V1.0.2"            /* 软件版本 */
 #define LOCAL_INET_ADDR     "127.0.0.1"         /* 本地内部地址，内部通信 */
 #define LOG_UDP_PORT        9110                /* udp服务器发送端口 */
+#define MAX_RECV_NUMBER     32                  /* 一次recvmmsg最多接收的数据报个数 */
+#define LOG_UNIX_PATH       "/tmp/avic_log.sock"    /* AF_UNIX接收地址，与log.h一致 */
+#define LOG_SHM_NAME        "/avic_log"         /* 共享内存队列名称，与log.h一致 */
+#define LOG_SHM_SIZE        (8 * 1024 * 1024)   /* 共享内存队列大小 */
+#define LOG_WRITE_BUF_SIZE  (512 * 1024)        /* 每块写缓存大小 */
+#define LOG_WRITE_BUF_NUMBER 4                  /* 写缓存块数，io_uring写文件时轮流使用 */
+#define LOG_FLUSH_SIZE      (256 * 1024)        /* 缓存达到该长度时写文件 */
+#define LOG_FLUSH_MS        200                 /* 缓存数据最长停留时间，毫秒 */
+#define LOG_SYNC_MS         1000                /* 默认fdatasync间隔，毫秒 */
+#define LOG_SYNC_USER_DATA  LOG_WRITE_BUF_NUMBER    /* fdatasync请求的用户数据，写请求为缓存下标 */
+#define LOG_INDEX_PENDING   32                  /* 等待写入索引文件的索引项个数上限 */
 
 /*
-* @brief 消息数据结构体
+* @brief 一块写缓存
 */
-typedef struct Message{
-    char* mes;
-    int   len;
-}MessageData;
+typedef struct LogWriteBuf{
+    char*           data;                           /* 缓存 */
+    size_t          len;                            /* 提交时的长度 */
+    off_t           offset;                         /* 提交时的文件偏移 */
+    int             fd;                             /* 提交时的日志文件，滚动后仍指向旧文件 */
+    int             busy;                           /* 1表示已提交io_uring且未完成 */
+}LogWriteBufData;
 
 /*
-* @brief 消息队列结构体
+* @brief 日志写缓存
+* @note  格式化后的日志直接追加到当前缓存，攒够LOG_FLUSH_SIZE或停留超过LOG_FLUSH_MS才写文件；
+*        使用io_uring时提交后换下一块缓存继续接收，磁盘慢时不阻塞接收循环，否则同步pwrite；
+*        文件大小在内存中累计，每次按偏移写入；滚动只改名并打开新文件，压缩和清理在归档线程；
+*        每LOG_INDEX_BLOCK字节生成一个索引项，随缓存一起写入日志文件旁的".idx"
 */
-typedef struct MessageNumber
-{
-    int write_flage;                                /* 1代表开始写，0代表停止写 */
-    int index;
-    MessageData message_data[MAX_MESSAGE_NUMBER];
-}MessageNumberData;
+typedef struct LogWriter{
+    int             fd;                             /* 当前日志文件 */
+    char*           buf;                            /* 当前写缓存 */
+    size_t          len;                            /* 当前缓存中待写长度 */
+    size_t          capcity;                        /* 每块缓存大小 */
+    int             cur;                            /* 当前缓存下标 */
+    int             in_flight;                      /* 未完成的写请求个数 */
+    LogWriteBufData bufs[LOG_WRITE_BUF_NUMBER];     /* 写缓存 */
+    off_t           file_size;                      /* 已提交的长度，即下一次写入的偏移 */
+    off_t           max_size;                       /* 单个文件大小，超过后滚动 */
+    int             retire_fd;                      /* 已滚动但还有写请求未完成的文件，-1表示没有 */
+    char            retire_path[PATH_MAX];          /* 滚动后的文件路径 */
+    int             idx_fd;                         /* 当前日志文件的索引文件 */
+    LogIndexEntry   block;                          /* 正在统计的块 */
+    LogIndexEntry   entries[LOG_INDEX_PENDING];     /* 已结束、等待写入的索引项 */
+    int             entry_number;                   /* entries中的个数 */
+    struct timespec first;                          /* 当前缓存中最早一条日志的时间 */
+    int             use_uring;                      /* 1表示使用io_uring写文件 */
+    LogUringData    uring;                          /* io_uring实例 */
+    int             sync_ms;                        /* fdatasync间隔，0表示不调用 */
+    int             sync_pending;                   /* io_uring中有未完成的fdatasync */
+    int             dirty;                          /* 上次fdatasync后有新写入 */
+    struct timespec last_sync;                      /* 上次fdatasync的时间 */
+}LogWriterData;
+
+/*
+* @brief 时间戳缓存
+* @note  日期和秒每秒只格式化一次，每条日志只填写微秒
+*/
+typedef struct LogTimeCache{
+    time_t          sec;                            /* 已格式化的秒 */
+    char            prefix[80];                     /* "[YYYY-MM-DD HH:MM:SS."，按int最大宽度留足空间 */
+}LogTimeCacheData;
 
-static MessageNumberData mes_num_data;
+static LogWriterData log_writer;
+static LogTimeCacheData time_cache = {-1, ""};      /* 接收和共享内存线程在write_lock内使用 */
+static LogSiteTable site_table;                     /* 二进制日志调用点 */
+static char recv_bufs[MAX_RECV_NUMBER][MAX_BUF_LEN];   /* 接收缓存 */
+static pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;  /* socket接收和共享内存线程互斥写文件 */
+static volatile sig_atomic_t log_exit = 0;          /* 收到退出信号 */
+static char log_file_path[MAX_BUF_LEN];             /* 当前日志文件路径 */
+static struct mmsghdr recv_msgs[MAX_RECV_NUMBER];
+static struct iovec recv_iovs[MAX_RECV_NUMBER];
 
 /*
 * @brief      获取日志文件夹路径
@@ -101,32 +164,48 @@ static int GetLogFolderPath(char *path, int maxlen)
 }
 
 /*
-* @brief      获取系统时间字符串
-* @note
-* @param[out] buf     时间数据指针
-* @param[in]  maxlen  数据最大长度
-* @param[in]  off_time时区偏差
-* @return     执行结果
-* @retval     0       成功
-* @retval     其他    失败
+* @brief      格式化时间戳前缀
+* @note       秒数与缓存相同时只填写微秒；输出固定LOG_TIME_PREFIX_LEN字节，不含'\0'
+* @param[in]  c           时间戳缓存
+* @param[in]  event_time  自1970年起的微秒数
+* @param[out] out         输出位置
+* @return     无
 */
-int GetSysTimeString(char *buf, int max_len, int off_time)
+static void LogTimeFormat(LogTimeCacheData* c, uint64_t event_time, char* out)
 {
-    if ((buf == NULL) || (max_len <= 0) || (off_time < -11) || (off_time > 11)) {
-        return -1;
-    }
+    time_t sec = event_time / 1000000, local;
+    unsigned int usec = event_time % 1000000;
+    struct tm tm_now;
+    int i;
 
-    struct tm *tm_now;
-    struct timeval tv_now;
+    if (sec != c->sec) {
+        local = sec + LOG_TIME_ZONE * 3600;
+        gmtime_r(&local, &tm_now);
+        snprintf(c->prefix, sizeof(c->prefix), "[%04d-%02d-%02d %02d:%02d:%02d.",
+                 tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday,
+                 tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec);
+        c->sec = sec;
+    }
+    memcpy(out, c->prefix, LOG_TIME_SEC_LEN);
+    for (i = LOG_TIME_SEC_LEN + 5; i >= LOG_TIME_SEC_LEN; i--) {
+        out[i] = '0' + usec % 10;
+        usec /= 10;
+    }
+    out[LOG_TIME_SEC_LEN + 6] = ']';
+    out[LOG_TIME_SEC_LEN + 7] = ':';
+}
 
-    gettimeofday(&tv_now, NULL);
-    tv_now.tv_sec += (off_time * 3600);
-    tm_now = gmtime(&tv_now.tv_sec);
-    snprintf(buf, max_len, "%d-%02d-%02d %02d:%02d:%02d.%06d",
-             tm_now->tm_year + 1900, tm_now->tm_mon + 1, tm_now->tm_mday,
-             tm_now->tm_hour, tm_now->tm_min, tm_now->tm_sec, (int)tv_now.tv_usec);
+/*
+* @brief      取接收时间
+* @note       只用于不带事件时间的旧文本记录，精度为一个时钟节拍
+* @return     自1970年起的微秒数
+*/
+static uint64_t LogTimeCoarse(void)
+{
+    struct timespec ts;
 
-    return 0;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
 }
 
 /*
@@ -158,81 +237,421 @@ static int InitLogFile(char *path)
 }
 
 /*
-* @brief      缓存日志
+* @brief      两个时间之差
 * @note
-* @param[in]  buf      buf数据
-* @param[in]  buf_size buf数据长度
+* @param[in]  start   起始时间
+* @param[in]  end     结束时间
+* @return     毫秒数
+*/
+static long LogElapsedMs(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000 + (end->tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/*
+* @brief      打开索引文件
+* @note       日志文件为空时清空旧索引；没有文件头时写入文件头，末尾不完整的索引项截掉；
+*             索引文件打不开时只是查询变慢，不影响写日志
+* @param[in]  w       写缓存
+* @param[in]  path    日志文件路径
+* @return     无
+*/
+static void LogWriterIndexOpen(LogWriterData* w, const char* path)
+{
+    char idx_path[MAX_BUF_LEN + 16];
+    LogIndexHead head;
+    struct stat st;
+    off_t tail;
+
+    w->block.length = 0;
+    w->entry_number = 0;
+    snprintf(idx_path, sizeof(idx_path), "%s%s", path, LOG_INDEX_SUFFIX);
+    w->idx_fd = open(idx_path, O_WRONLY | O_CREAT | O_APPEND | ((w->file_size == 0) ? O_TRUNC : 0), 0666);
+    if ((w->idx_fd < 0) || (fstat(w->idx_fd, &st) != 0)) {
+        return;
+    }
+    if (st.st_size < (off_t)sizeof(head)) {
+        memset(&head, 0, sizeof(head));
+        memcpy(head.magic, LOG_INDEX_MAGIC, sizeof(head.magic));
+        head.entry_size = sizeof(LogIndexEntry);
+        if ((ftruncate(w->idx_fd, 0) != 0) || (write(w->idx_fd, &head, sizeof(head)) != sizeof(head))) {
+            close(w->idx_fd);
+            w->idx_fd = -1;
+        }
+        return;
+    }
+    tail = (st.st_size - sizeof(head)) % sizeof(LogIndexEntry);
+    if ((tail != 0) && (ftruncate(w->idx_fd, st.st_size - tail) != 0)) {
+        close(w->idx_fd);
+        w->idx_fd = -1;
+    }
+}
+
+/*
+* @brief      写出已结束的索引项
+* @note       索引项可能先于对应的日志落盘，查询时按日志文件实际长度截断
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterIndexWrite(LogWriterData* w)
+{
+    if ((w->entry_number > 0) && (w->idx_fd >= 0)) {
+        if (write(w->idx_fd, w->entries, w->entry_number * sizeof(LogIndexEntry)) < 0) {
+            printf("write log index err\n");
+        }
+    }
+    w->entry_number = 0;
+}
+
+/*
+* @brief      结束当前块
+* @note       索引项放入entries，下次写文件时一起写出
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterIndexEnd(LogWriterData* w)
+{
+    if (w->block.length == 0) {
+        return;
+    }
+    if (w->entry_number == LOG_INDEX_PENDING) {
+        LogWriterIndexWrite(w);
+    }
+    w->entries[w->entry_number++] = w->block;
+    w->block.length = 0;
+}
+
+/*
+* @brief      打开日志文件
+* @note       按偏移写入，不使用O_APPEND；文件大小取自fstat；同时打开索引文件
+* @param[in]  w       写缓存
+* @param[in]  path    文件路径
+* @return     执行结果
 * @retval     0       成功
 * @retval     其他    失败
 */
-static int LogBuffer(char* buf, int buf_size)
+static int LogWriterOpen(LogWriterData* w, const char* path)
 {
-    int index;
-    if ((buf == NULL) || (buf_size > MAX_STRING_SIZE) || (mes_num_data.write_flage == ENABLE_WRITE_FLAG)) 
-    {
+    struct stat st;
+
+    w->fd = open(path, O_WRONLY | O_CREAT, 0666);
+    if (w->fd < 0) {
         return -1;
     }
-    index = mes_num_data.index;
-
-    if (index >= MAX_MESSAGE_NUMBER) {
-        mes_num_data.index = 0;
-        mes_num_data.write_flage = ENABLE_WRITE_FLAG;
-        return 0;
-    } 
-    mes_num_data.message_data[index].mes = (char* )malloc(buf_size);
-    memcpy(mes_num_data.message_data[index].mes, buf, buf_size);
-    mes_num_data.message_data[index].len = buf_size;
-    mes_num_data.index++;
-
+    w->file_size = (fstat(w->fd, &st) == 0) ? st.st_size : 0;
+    LogWriterIndexOpen(w, path);
     return 0;
 }
 
 /*
-* @brief      日志文件命名
-* @note
-* @param[in]  log_fp     文件描述符
-* @param[in]  file_size  文件大小
-* @param[in]  path       文件路径
-* @retval     无
+* @brief      同步写文件
+* @note       处理部分写和EINTR；写失败时丢弃，不阻塞接收
+* @param[in]  fd      文件句柄
+* @param[in]  buf     数据
+* @param[in]  len     数据长度
+* @param[in]  offset  文件偏移
+* @return     无
 */
-static void LogFileRename(FILE **log_fp, int file_size, char* path)
+static void LogWriterPwrite(int fd, const char* buf, size_t len, off_t offset)
 {
-    int ret = 0;
-    char tmp_buf1[MAX_BUF_LEN] = {0}, tmp_buf2[MAX_BUF_LEN] = {0};
-
-    /* check log file size */
-    if (file_size > MAX_LOG_SIZE) {
-        /* close log_fp */
-        fclose(*log_fp);
-        for (int i = MAX_LOG_NUM; i > 0; i--) {
-            memset(tmp_buf1, 0, MAX_BUF_LEN);
-            sprintf(tmp_buf1, "%s%d", path, i);
-            /* check log file exist */
-            ret = access(tmp_buf1, F_OK);
-            if (ret == 0) {
-                if (i == MAX_LOG_NUM) {
-                    /* remove oldest log file */
-                    remove(tmp_buf1);
-                } else {
-                    /* rename log file */
-                    memset(tmp_buf2, 0, MAX_BUF_LEN);
-                    sprintf(tmp_buf2, "%s%d", path, (i + 1));
-                    rename(tmp_buf1, tmp_buf2);
-                }
+    size_t off = 0;
+    ssize_t n;
+
+    while (off < len) {
+        n = pwrite(fd, buf + off, len - off, offset + off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            break;
         }
-        /* rename log file */
-        memset(tmp_buf2, 0, MAX_BUF_LEN);
-        sprintf(tmp_buf2, "%s%d", path, 1);
-        rename(path, tmp_buf2);
-        *log_fp = fopen(path, "a+");
-        if (NULL == *log_fp) {
-            printf("open log file err\n");
+        off += n;
+    }
+}
+
+/*
+* @brief      交出已滚动的文件
+* @note       旧文件上的写请求全部完成后才关闭并交给归档线程
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterRetire(LogWriterData* w)
+{
+    int i;
+
+    if (w->retire_fd < 0) {
+        return;
+    }
+    for (i = 0; i < LOG_WRITE_BUF_NUMBER; i++) {
+        if (w->bufs[i].busy && (w->bufs[i].fd == w->retire_fd)) {
             return;
         }
+    }
+    close(w->retire_fd);
+    w->retire_fd = -1;
+    LogArchivePush(w->retire_path);
+}
+
+/*
+* @brief      收割io_uring完成事件
+* @note       短写或写失败时同步补写，缓存在完成前不会被复用
+* @param[in]  w       写缓存
+* @param[in]  wait    1表示没有完成事件时阻塞等待
+* @return     无
+*/
+static void LogWriterComplete(LogWriterData* w, int wait)
+{
+    LogUringEvent events[LOG_URING_ENTRIES];
+    LogWriteBufData* b;
+    size_t done;
+    int number, i;
+
+    number = LogUringReap(&(w->uring), wait, events, LOG_URING_ENTRIES);
+    for (i = 0; i < number; i++) {
+        if (events[i].user_data == LOG_SYNC_USER_DATA) {
+            w->sync_pending = 0;
+            continue;
+        }
+        b = &(w->bufs[events[i].user_data]);
+        done = (events[i].res > 0) ? (size_t)events[i].res : 0;
+        if (done < b->len) {
+            LogWriterPwrite(b->fd, b->data + done, b->len - done, b->offset + done);
+        }
+        b->busy = 0;
+        w->in_flight--;
+    }
+    LogWriterRetire(w);
+}
+
+/*
+* @brief      等待io_uring中的请求全部完成
+* @note
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterDrain(LogWriterData* w)
+{
+    while ((w->in_flight > 0) || w->sync_pending) {
+        LogWriterComplete(w, 1);
+    }
+}
+
+/*
+* @brief      当前缓存写入文件
+* @note       使用io_uring时提交后换下一块缓存，只有全部缓存都在写时才等待；
+*             提交队列满或未使用io_uring时同步写
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterFlush(LogWriterData* w)
+{
+    LogWriteBufData* b = &(w->bufs[w->cur]);
+
+    LogWriterIndexWrite(w);
+    if (w->len == 0) {
+        return;
+    }
+    b->len = w->len;
+    b->offset = w->file_size;
+    b->fd = w->fd;
+    w->file_size += w->len;
+    w->dirty = 1;
+    w->len = 0;
+
+    if (w->use_uring &&
+        (LogUringWrite(&(w->uring), w->fd, w->cur, b->data, b->len, b->offset, w->cur) == 0)) {
+        b->busy = 1;
+        w->in_flight++;
+        w->cur = (w->cur + 1) % LOG_WRITE_BUF_NUMBER;
+        while (w->bufs[w->cur].busy) {
+            LogWriterComplete(w, 1);
+        }
+        w->buf = w->bufs[w->cur].data;
+        return;
+    }
+    LogWriterPwrite(w->fd, b->data, b->len, b->offset);
+}
+
+/*
+* @brief      日志文件滚动
+* @note       当前文件和索引文件改名为带时间的滚动文件名后打开新文件；旧文件上的写请求完成后交给归档线程，
+*             接收循环中只有改名和打开
+* @param[in]  w       写缓存
+* @param[in]  path    文件路径
+* @return     无
+*/
+static void LogWriterRotate(LogWriterData* w, const char* path)
+{
+    char idx_path[MAX_BUF_LEN + 16], retire_idx_path[PATH_MAX + 16];
+
+    LogWriterIndexEnd(w);
+    LogWriterFlush(w);
+    /* 上一个滚动文件还在写时先等它写完，只在滚动间隔极短时发生 */
+    if (w->retire_fd >= 0) {
+        LogWriterDrain(w);
+    }
+    LogArchiveRollName(path, w->retire_path, sizeof(w->retire_path));
+    if (rename(path, w->retire_path) != 0) {
+        return;
+    }
+    w->retire_fd = w->fd;
+    if (w->idx_fd >= 0) {
+        close(w->idx_fd);
+        snprintf(idx_path, sizeof(idx_path), "%s%s", path, LOG_INDEX_SUFFIX);
+        snprintf(retire_idx_path, sizeof(retire_idx_path), "%s%s", w->retire_path, LOG_INDEX_SUFFIX);
+        rename(idx_path, retire_idx_path);
+    }
+    if (LogWriterOpen(w, path) != 0) {
+        printf("open log file err\n");
+    }
+    w->file_size = 0;
+    w->dirty = 0;
+    LogWriterRetire(w);
+}
+
+/*
+* @brief      初始化写缓存并打开日志文件
+* @note       写缓存按页对齐一次分配；io_uring不可用时退回同步写
+* @param[in]  w           写缓存
+* @param[in]  path        文件路径
+* @param[in]  use_uring   1表示尝试使用io_uring
+* @param[in]  sync_ms     fdatasync间隔，0表示不调用
+* @param[in]  max_size    单个文件大小，超过后滚动
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+static int LogWriterInit(LogWriterData* w, const char* path, int use_uring, int sync_ms, off_t max_size)
+{
+    struct iovec iovs[LOG_WRITE_BUF_NUMBER];
+    int i;
+
+    memset(w, 0, sizeof(*w));
+    w->capcity = LOG_WRITE_BUF_SIZE;
+    w->sync_ms = sync_ms;
+    w->max_size = max_size;
+    w->retire_fd = -1;
+    w->idx_fd = -1;
+    for (i = 0; i < LOG_WRITE_BUF_NUMBER; i++) {
+        if (posix_memalign((void** )&(w->bufs[i].data), 4096, w->capcity) != 0) {
+            return -1;
+        }
+        iovs[i].iov_base = w->bufs[i].data;
+        iovs[i].iov_len = w->capcity;
+    }
+    w->buf = w->bufs[0].data;
+    clock_gettime(CLOCK_MONOTONIC, &(w->last_sync));
+    if (LogWriterOpen(w, path) != 0) {
+        return -1;
+    }
+    w->use_uring = use_uring && (LogUringInit(&(w->uring), iovs, LOG_WRITE_BUF_NUMBER) == 0);
+    return 0;
+}
+
+/*
+* @brief      预留缓存空间
+* @note       剩余空间不足时先写文件
+* @param[in]  w       写缓存
+* @param[in]  need    需要的长度，不超过缓存大小
+* @return     可写位置
+*/
+static char* LogWriterReserve(LogWriterData* w, size_t need)
+{
+    if (w->len + need > w->capcity) {
+        LogWriterFlush(w);
+    }
+    if (w->len == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &(w->first));
+    }
+    return w->buf + w->len;
+}
+
+/*
+* @brief      提交已写入预留空间的日志
+* @note       一次提交一行，计入当前块；文件超过max_size时滚动，否则缓存达到LOG_FLUSH_SIZE时写文件
+* @param[in]  w           写缓存
+* @param[in]  len         提交长度
+* @param[in]  event_time  事件时间，微秒，0表示不计入索引时间范围
+* @return     无
+*/
+static void LogWriterCommit(LogWriterData* w, size_t len, uint64_t event_time)
+{
+    LogIndexAdd(&(w->block), w->file_size + w->len, w->buf + w->len, len, event_time);
+    if (w->block.length >= LOG_INDEX_BLOCK) {
+        LogWriterIndexEnd(w);
+    }
+    w->len += len;
+    if (w->file_size + (off_t)w->len > w->max_size) {
+        LogWriterRotate(w, log_file_path);
+    } else if (w->len >= LOG_FLUSH_SIZE) {
+        LogWriterFlush(w);
+    }
+}
+
+/*
+* @brief      定时处理
+* @note       收割已完成的写请求；缓存中最早的日志停留超过LOG_FLUSH_MS时写文件；
+*             有新写入且距上次超过sync_ms时fdatasync，使用io_uring时异步执行
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterTick(LogWriterData* w)
+{
+    struct timespec now;
+
+    if ((w->in_flight > 0) || w->sync_pending) {
+        LogWriterComplete(w, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((w->len > 0) && (LogElapsedMs(&(w->first), &now) >= LOG_FLUSH_MS)) {
+        LogWriterFlush(w);
+    }
+    if ((w->sync_ms > 0) && w->dirty && !w->sync_pending &&
+        (LogElapsedMs(&(w->last_sync), &now) >= w->sync_ms)) {
+        w->last_sync = now;
+        w->dirty = 0;
+        if (w->use_uring && (LogUringSync(&(w->uring), w->fd, LOG_SYNC_USER_DATA) == 0)) {
+            w->sync_pending = 1;
+        } else {
+            fdatasync(w->fd);
+        }
+    }
+}
 
+/*
+* @brief      关闭日志文件
+* @note       写出缓存和索引，等待io_uring请求完成后落盘
+* @param[in]  w       写缓存
+* @return     无
+*/
+static void LogWriterClose(LogWriterData* w)
+{
+    LogWriterIndexEnd(w);
+    LogWriterFlush(w);
+    LogWriterDrain(w);
+    LogWriterRetire(w);
+    if (w->sync_ms > 0) {
+        fdatasync(w->fd);
+    }
+    close(w->fd);
+    if (w->idx_fd >= 0) {
+        close(w->idx_fd);
+    }
+    if (w->use_uring) {
+        LogUringExit(&(w->uring));
     }
-    return;
+}
+
+/*
+* @brief      退出信号处理
+* @note       只置标志，由主循环写出缓存后退出
+* @param[in]  sig     信号
+* @return     无
+*/
+static void LogExitHandler(int sig)
+{
+    (void)sig;
+    log_exit = 1;
 }
 
 /*
@@ -271,6 +690,36 @@ int LogCreateInetDgramSocket(int* fd, const char* addr, unsigned short port)
     return 0;
 }
 
+/*
+* @brief      创建AF_UNIX数据报服务端socket
+* @note       绑定前删除残留的socket文件，权限放开给其他用户的进程
+* @param[out] fd      socket句柄
+* @param[in]  path    socket文件路径
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+static int LogCreateUnixDgramSocket(int* fd, const char* path)
+{
+    struct sockaddr_un sock_addr;
+    int tmp_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+    if (tmp_fd < 0) {
+        return -1;
+    }
+    memset(&sock_addr, 0, sizeof(sock_addr));
+    sock_addr.sun_family = AF_UNIX;
+    strncpy(sock_addr.sun_path, path, sizeof(sock_addr.sun_path) - 1);
+    unlink(path);
+    if (bind(tmp_fd, (struct sockaddr *)&sock_addr, sizeof(sock_addr)) < 0) {
+        close(tmp_fd);
+        return -1;
+    }
+    chmod(path, 0666);
+    *fd = tmp_fd;
+    return 0;
+}
+
 /*
 * @brief                安全字符格式化函数
 * @note       
@@ -304,6 +753,83 @@ LogSafeSprintf(char* buf, int max_len, char* fmt, ...)
     return ret;
 }
 
+/*
+* @brief      处理一个数据报
+* @note       依次取出其中的文本记录和二进制记录写入日志；调用者持有write_lock
+* @param[in]  recv_buf    数据报
+* @param[in]  bytes_read  数据报长度
+* @return     无
+*/
+static void LogHandleDatagram(const char* recv_buf, int bytes_read)
+{
+    uint64_t event_time;
+    char* out;
+    int ret, tmp_len, max_len;
+
+    /* 一个数据报内依次放多条记录，每条格式化为"[时间]:内容\n"直接写入写缓存 */
+    for (max_len = 0; max_len < bytes_read; max_len += tmp_len) {
+        out = LogWriterReserve(&log_writer, LOG_TIME_PREFIX_LEN + MAX_BUF_LEN + 1);
+        /* 带记录头的记录按调用点格式化或拷贝文本，登记记录不写文件 */
+        if ((recv_buf[max_len] == LOG_BIN_SITE) || (recv_buf[max_len] == LOG_BIN_DATA) ||
+            (recv_buf[max_len] == LOG_BIN_TEXT)) {
+            ret = LogBinaryDecode(&site_table, recv_buf + max_len, bytes_read - max_len, &tmp_len,
+                                  &event_time, out + LOG_TIME_PREFIX_LEN, MAX_BUF_LEN);
+            if (ret < 0) {
+                break;
+            } else if (ret == 0) {
+                continue;
+            }
+        } else {
+            /* 不带记录头的旧文本记录必须以'\0'结尾，数据报可能位于共享内存中，不在原地补'\0' */
+            tmp_len = strnlen(recv_buf + max_len, bytes_read - max_len);
+            if (tmp_len == bytes_read - max_len) {
+                break;
+            }
+            ret = tmp_len++;
+            if (ret == 0) {
+                continue;
+            }
+            memcpy(out + LOG_TIME_PREFIX_LEN, recv_buf + max_len, ret);
+            event_time = LogTimeCoarse();
+        }
+        LogTimeFormat(&time_cache, event_time, out);
+        out[LOG_TIME_PREFIX_LEN + ret] = '\n';
+        LogWriterCommit(&log_writer, LOG_TIME_PREFIX_LEN + ret + 1, event_time);
+    }
+}
+
+/*
+* @brief      共享内存队列接收线程
+* @note       客户端可以随时改写共享内存，记录先复制到本线程缓存再处理；超过缓存的记录丢弃
+* @param[in]  arg     共享内存队列
+* @return     NULL
+*/
+static void* LogShmThread(void* arg)
+{
+    static char shm_buf[MAX_BUF_LEN];                   /* 记录副本 */
+    ShmQueueData* q = (ShmQueueData* )arg;
+    const char* data;
+    size_t len;
+
+    while (1) {
+        data = (const char* )ShmQueuePeek(q, &len, NULL);
+        if (data == NULL) {
+            usleep(10);
+            continue;
+        }
+        if (len > sizeof(shm_buf)) {
+            ShmQueueRelease(q);
+            continue;
+        }
+        memcpy(shm_buf, data, len);
+        ShmQueueRelease(q);
+        pthread_mutex_lock(&write_lock);
+        LogHandleDatagram(shm_buf, len);
+        pthread_mutex_unlock(&write_lock);
+    }
+    return NULL;
+}
+
 /*
 * @brief      main函数
 *
@@ -313,10 +839,47 @@ LogSafeSprintf(char* buf, int max_len, char* fmt, ...)
 */
 int main(int argc, char *argv[])
 {
-    int ret = -1, srv_fd = -1, file_size = 0, bytes_read = 0, tmp_len, max_len;
-    char log_file_path[MAX_BUF_LEN] = {0}, tmp_buf1[MAX_BUF_LEN] = {0}, tmp_buf2[MAX_BUF_LEN] = {0}, time_buf[MAX_BUF_LEN] = {0};
-    char log_write_buf[MAX_BUF_LEN] = {0}, recv_buf[MAX_BUF_LEN] = {0};
+    int ret = -1, srv_fd = -1, unix_fd = -1, recv_number, fd_number = 0, i, j;
+    int use_uring = 1, sync_ms = LOG_SYNC_MS;
+    LogArchiveConfig archive = {MAX_LOG_SIZE, MAX_LOG_NUM, MAX_LOG_TOTAL, 0, LOG_GZIP_LEVEL, LOG_TIME_ZONE};
+    struct pollfd fds[2];
+    ShmQueueData* shm_q;
+    pthread_t shm_thread;
     
+    /* -n不使用io_uring，-s设置fdatasync间隔(毫秒，0不调用)；
+       -f单个文件大小(KB)，-c保留滚动文件个数，-S滚动文件总大小(MB)，-t保留小时数，-z压缩级别，后四项0表示不限或不压缩 */
+    while ((ret = getopt(argc, argv, "ns:f:c:S:t:z:")) != -1) {
+        switch (ret) {
+        case 'n':
+            use_uring = 0;
+            break;
+        case 's':
+            sync_ms = atoi(optarg);
+            break;
+        case 'f':
+            archive.file_size = (off_t)atoi(optarg) * 1024;
+            break;
+        case 'c':
+            archive.max_number = atoi(optarg);
+            break;
+        case 'S':
+            archive.max_total = (off_t)atoi(optarg) * 1024 * 1024;
+            break;
+        case 't':
+            archive.max_hours = atoi(optarg);
+            break;
+        case 'z':
+            archive.level = atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-n] [-s sync_ms] [-f file_kb] [-c count] [-S total_mb] [-t hours] [-z level]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (archive.file_size <= 0) {
+        archive.file_size = MAX_LOG_SIZE;
+    }
+
     /* 无视SIGPIPE信号，防止连接断开时产生SIGPIPE信号终止进程 */
     signal(SIGPIPE, SIG_IGN);
     
@@ -326,6 +889,16 @@ int main(int argc, char *argv[])
         printf("log create_server_unix_dgram_socket err\n");
         return -1;
     }
+    fds[fd_number].fd = srv_fd;
+    fds[fd_number++].events = POLLIN;
+
+    /* AF_UNIX和共享内存传输可选，创建失败时只用udp */
+    if (LogCreateUnixDgramSocket(&unix_fd, LOG_UNIX_PATH) == 0) {
+        fds[fd_number].fd = unix_fd;
+        fds[fd_number++].events = POLLIN;
+    } else {
+        printf("log create unix socket err\n");
+    }
     
     /* 初始化日志文件名 */
     ret = InitLogFile(log_file_path);
@@ -334,58 +907,68 @@ int main(int argc, char *argv[])
         return -1;
     }
     
-    /* 打开日志文件 */
-    FILE *log_fp = fopen(log_file_path, "a+");
-    if (NULL == log_fp) {
+    /* 打开日志文件，写缓存一次分配 */
+    if (LogWriterInit(&log_writer, log_file_path, use_uring, sync_ms, archive.file_size) != 0) {
         printf("open log file err\n");
         return -1;
     }
+
+    /* 滚动文件由归档线程压缩和清理，启动失败时滚动文件保持未压缩 */
+    if (LogArchiveStart(log_file_path, &archive) != 0) {
+        printf("log start archive thread err\n");
+    }
     
     /* 写入日志版本 */
-    ret = fprintf(log_fp, "%s %s \n", "AVIC Log SoftWare Version", SOFTWARE_VERSION);
-    fflush(log_fp);
+    ret = snprintf(LogWriterReserve(&log_writer, MAX_STRING_SIZE), MAX_STRING_SIZE, "%s %s \n",
+                   "AVIC Log SoftWare Version", SOFTWARE_VERSION);
+    LogWriterCommit(&log_writer, ret, 0);
+    LogWriterFlush(&log_writer);
 
-    while (1) {
-        memset(recv_buf, 0, MAX_BUF_LEN);
-        bytes_read = recvfrom(srv_fd, recv_buf, sizeof(recv_buf), 0, NULL, NULL);
-        if (bytes_read <= 0) {
-            usleep(10);
-            /* perror("recvfrom error\n"); */
+    /* 退出前写出缓存中的日志 */
+    signal(SIGINT, LogExitHandler);
+    signal(SIGTERM, LogExitHandler);
+
+    shm_q = ShmQueueOpen(LOG_SHM_NAME, LOG_SHM_SIZE, 1);
+    if ((shm_q == NULL) || (pthread_create(&shm_thread, NULL, LogShmThread, shm_q) != 0)) {
+        printf("log create shm queue err\n");
+    }
+
+    /* 预先挂好接收缓存，一次系统调用收多个数据报 */
+    for (i = 0; i < MAX_RECV_NUMBER; i++) {
+        recv_iovs[i].iov_base = recv_bufs[i];
+        recv_iovs[i].iov_len = MAX_BUF_LEN;
+        recv_msgs[i].msg_hdr.msg_iov = &recv_iovs[i];
+        recv_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (!log_exit) {
+        /* 空闲时也按LOG_FLUSH_MS唤醒，写出缓存中的日志 */
+        ret = poll(fds, fd_number, LOG_FLUSH_MS);
+        pthread_mutex_lock(&write_lock);
+        LogWriterTick(&log_writer);
+        pthread_mutex_unlock(&write_lock);
+        if (ret <= 0) {
             continue;
         }
-        while (1) {
-            tmp_len = 0, max_len = 0;
-            tmp_len = strlen(recv_buf + max_len) + 1;
-            memset(time_buf, 0, sizeof(time_buf));
-            GetSysTimeString(time_buf, sizeof(time_buf), 8); /* 使用北京时间 */
-            ret = LogSafeSprintf(log_write_buf, MAX_BUF_LEN, "[%s]:%s", time_buf, (recv_buf + max_len));
-            if (!ret) {
-                break;
-            } else {
-                log_write_buf[ret] = '\0';
+        for (j = 0; j < fd_number; j++) {
+            if (!(fds[j].revents & POLLIN)) {
+                continue;
             }
-            LogBuffer(log_write_buf, ret + 1);
-
-            if (mes_num_data.write_flage == ENABLE_WRITE_FLAG) {
-                for (int index = 0; index < MAX_MESSAGE_NUMBER; index++) {
-                    fprintf(log_fp, "%s\n", mes_num_data.message_data[index].mes);
-                    free(mes_num_data.message_data[index].mes);
-                    mes_num_data.message_data[index].mes = NULL;
-
-                    fseek(log_fp, 0L, SEEK_END);
-                    file_size = ftell(log_fp);
-                    /* rename log file */
-                    LogFileRename(&log_fp, file_size, log_file_path);
-                }
-                mes_num_data.write_flage = 0;
-            } 
-            
-            max_len += tmp_len;
-            if (max_len >= bytes_read) {
-                break;
+            /* 取走该socket上已到达的数据报 */
+            recv_number = recvmmsg(fds[j].fd, recv_msgs, MAX_RECV_NUMBER, MSG_DONTWAIT, NULL);
+            if (recv_number <= 0) {
+                continue;
+            }
+            pthread_mutex_lock(&write_lock);
+            for (i = 0; i < recv_number; i++) {
+                LogHandleDatagram(recv_bufs[i], recv_msgs[i].msg_len);
             }
+            pthread_mutex_unlock(&write_lock);
         }
     }
+    pthread_mutex_lock(&write_lock);
+    LogWriterClose(&log_writer);
+    LogArchiveStop();
     close(srv_fd);
     return 0;
-}
\ No newline at end of file
+}
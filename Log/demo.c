@@ -30,6 +30,8 @@ void testLog(void* thread)
 
 		LOG(ASSERT, TAG_ID, READ_WRITE, "%s:%d ", my_data->message, my_data->thread_id);
 
+		LOG_BIN(INFO, TAG_ID, ONLY_WRITE, "%s:%d binary", my_data->message, my_data->thread_id);
+
 		LOG_BUF("start test", number, strlen(number), ERROR, "BUF", READ_WRITE); 				/* sizeof(number) */
 	}
 	return;
@@ -40,6 +42,9 @@ int main(int argc,char *argv[])
 	/* 设置log日志等级，详见日志等级枚举 */
 	LogInit(VERBOSE, NULL, NULL);
 
+	/* 异步日志，调用线程只写本线程缓冲区 */
+	LogAsyncStart(0);
+
 	pthread_t tids[NUM_THREADS];
 	struct thread_data td[NUM_THREADS];
 
@@ -13,9 +13,94 @@
 * | 1.0.0 | 2021-4-7 | xh | create |
 */  
 
+#define _GNU_SOURCE
 #include "log.h"
+#include "../MessageQueue/shmQueue.h"
+#include <linux/futex.h>
 
 static LogFolter log_ft;
+uint32_t log_filter_generation = 2;                             /* 调用点缓存为0时总是重新计算 */
+
+#define LOG_CACHE_LINE_SIZE     64
+#define LOG_ALIGN(len)          (((len) + 7) & ~7u)
+
+/*
+* @brief 环形缓冲区中的记录头
+* @note  len为0表示回绕填充，读到后跳到缓冲区开头
+*/
+typedef struct LogRecordHead{
+    uint32_t  len;                                             /* 记录长度，记录为文本记录或二进制记录 */
+    uint8_t   level;                                           /* 日志级别 */
+    uint8_t   flag;                                            /* 打印标识 */
+    uint16_t  reserved;
+}LogRecordHead;
+
+/*
+* @brief 每线程日志环形缓冲区
+* @note  所属线程写、后台线程读的单生产者单消费者队列，读写下标各占一个缓存行
+*/
+typedef struct LogRing{
+    char*     buf;                                             /* 缓冲区 */
+    uint32_t  mask;                                            /* 容量减一 */
+    int       pid;                                             /* 所属进程ID */
+    long      tid;                                             /* 所属线程ID */
+    int       orphan;                                          /* 所属线程已退出，读空后释放 */
+    char      pad0[LOG_CACHE_LINE_SIZE - sizeof(char* ) - 2 * sizeof(uint32_t) - sizeof(long) - sizeof(int)];
+    uint32_t  tail;                                            /* 写下标，所属线程修改 */
+    char      pad1[LOG_CACHE_LINE_SIZE - sizeof(uint32_t)];
+    uint32_t  head;                                            /* 读下标，后台线程修改 */
+    char      pad2[LOG_CACHE_LINE_SIZE - sizeof(uint32_t)];
+}LogRingData;
+
+/*
+* @brief 异步日志状态
+*/
+typedef struct LogAsync{
+    int             running;                                   /* 后台线程运行中 */
+    int             ring_size;                                 /* 新线程缓冲区大小 */
+    int             fd;                                        /* 后台线程发送socket */
+    pthread_t       thread;                                    /* 后台线程 */
+    pthread_mutex_t lock;                                      /* 保护rings，持有期间不做I/O */
+    LogRingData*    rings[LOG_ASYNC_MAX_THREADS];              /* 已登记的线程缓冲区 */
+    int             ring_number;                               /* 已登记个数 */
+    unsigned long   dropped;                                   /* 丢弃条数 */
+    uint32_t        sleeping;                                  /* 后台线程休眠的futex，1表示休眠中 */
+}LogAsyncData;
+
+/*
+* @brief 后台线程发送批次
+* @note  多条记录依次拷贝进同一数据报，文本记录以'\0'结尾，二进制记录带长度；
+*        数据报写满或一轮读空后用一次sendmmsg发出
+*/
+typedef struct LogBatch{
+    union {
+        struct sockaddr_in  in;
+        struct sockaddr_un  un;
+    }                   addr;                                  /* 守护进程地址 */
+    struct mmsghdr      msgs[LOG_BATCH_NUMBER];
+    struct iovec        iovs[LOG_BATCH_NUMBER];
+    char                bufs[LOG_BATCH_NUMBER][LOG_BATCH_SIZE];
+    int                 number;                                /* 正在填充的数据报下标 */
+}LogBatchData;
+
+static LogBatchData log_batch;
+static LogAsyncData log_async = {0, LOG_ASYNC_RING_SIZE, -1, 0, PTHREAD_MUTEX_INITIALIZER, {NULL}, 0, 0, 0};
+static pthread_key_t log_ring_key;
+static pthread_once_t log_ring_once = PTHREAD_ONCE_INIT;
+static pthread_once_t log_atfork_once = PTHREAD_ONCE_INIT;
+static __thread LogRingData* log_tls_ring = NULL;
+static LogRingData log_ring_none;                              /* 登记失败的线程记为该值，不再重试，改为同步发送 */
+
+static int log_fd = -1;                                        /* 同步发送socket */
+static int log_transport = LOG_TRANSPORT_UDP;                  /* 传输方式 */
+static ShmQueueData* log_shm = NULL;                           /* 共享内存队列，各线程共用 */
+static unsigned long log_shm_dropped = 0;                      /* 共享内存队列满丢弃条数 */
+static pthread_mutex_t log_site_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t log_site_number = 0;                           /* 已登记调用点个数 */
+static uint32_t log_site_epoch = 1;                            /* 调用点登记版本，fork后子进程加1，全部重新登记 */
+
+static const char log_level_char[LEVEL_MAX] = {'V', 'D', 'I', 'W', 'E', 'A'};
+static const char* log_level_color[LEVEL_MAX] = {PRT_VERBOSE, PRT_DEBUG, PRT_INFO, PRT_WARNING, PRT_ERROR, PRT_ASSERT};
 
 /*
 * @brief      日志初始化
@@ -34,17 +119,55 @@ LogInit(int level, const char* keyword, const char* tag)
     }
 
     if (keyword == NULL) {
-        if (tag == NULL) {
-            return;
-        } else {
+        if (tag != NULL) {
             strncpy(log_ft.tag, tag, sizeof(log_ft.tag));
             log_ft.tag[MAX_FILTER_NAME_LEN] = '\0';
         }
-        return;
     } else {
         strncpy(log_ft.keyword, keyword, sizeof(log_ft.keyword));
         log_ft.keyword[MAX_FILTER_NAME_LEN] = '\0';
     }
+
+    /* 调用点缓存的过滤结果失效 */
+    __atomic_add_fetch(&log_filter_generation, 2, __ATOMIC_RELEASE);
+}
+
+/*
+* @brief      判断日志是否通过级别和标签过滤
+* @note
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @return     1通过，0过滤
+*/
+int
+LogEnabled(int level, const char* log_id)
+{
+    if ((level < (int)log_ft.level) || (level >= LEVEL_MAX)) {
+        return 0;
+    }
+    /* 标签过滤 */
+    if ((log_ft.tag[0] != '\0') && strcmp(log_id, log_ft.tag)) {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* @brief      重新计算调用点过滤结果
+* @note       先读版本再判断，期间LogInit修改条件时缓存带旧版本，下次会再计算
+* @param[out] cache   调用点缓存
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @return     1通过，0过滤
+*/
+int
+LogCacheRefresh(uint32_t* cache, int level, const char* log_id)
+{
+    uint32_t generation = __atomic_load_n(&log_filter_generation, __ATOMIC_ACQUIRE);
+    int enabled = LogEnabled(level, log_id);
+
+    __atomic_store_n(cache, generation | enabled, __ATOMIC_RELAXED);
+    return enabled;
 }
 
 /*
@@ -117,6 +240,115 @@ LogSendInetDgramSocket(int fd, const char *addr, unsigned short port, const char
     return sendto(fd, msg, len, 0, (struct sockaddr *)&sock_addr, sizeof(sock_addr));
 }
 
+/*
+* @brief      填写守护进程地址
+* @note       udp或AF_UNIX
+* @param[out] addr    地址
+* @return     地址长度
+*/
+static socklen_t
+LogTransportAddr(void* addr)
+{
+    struct sockaddr_in* in = (struct sockaddr_in* )addr;
+    struct sockaddr_un* un = (struct sockaddr_un* )addr;
+
+    if (log_transport == LOG_TRANSPORT_UNIX) {
+        memset(un, 0, sizeof(*un));
+        un->sun_family = AF_UNIX;
+        strncpy(un->sun_path, LOG_UNIX_PATH, sizeof(un->sun_path) - 1);
+        return sizeof(*un);
+    }
+    memset(in, 0, sizeof(*in));
+    in->sin_family = AF_INET;
+    in->sin_port = htons(LOG_UDP_PORT);
+    in->sin_addr.s_addr = inet_addr(LOCAL_INET_ADDR);
+    return sizeof(*in);
+}
+
+/*
+* @brief      创建发送端
+* @note       共享内存方式不需要socket，fd置-1
+* @param[out] fd      socket句柄
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+static int
+LogTransportOpen(int* fd)
+{
+    switch (log_transport) {
+    case LOG_TRANSPORT_UNIX:
+        *fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        return (*fd < 0) ? -1 : 0;
+    case LOG_TRANSPORT_SHM:
+        *fd = -1;
+        return (log_shm == NULL) ? -1 : 0;
+    default:
+        return LogCreateInetDgramSocket(fd, NULL, 0);
+    }
+}
+
+/*
+* @brief      发送一个数据报
+* @note       共享内存方式写入一条队列记录，队列满时最多等待wait_us，0不等待
+* @param[in]  fd      socket句柄
+* @param[in]  data    数据
+* @param[in]  len     数据长度
+* @param[in]  wait_us 共享内存队列满时最多等待时间，微秒
+* @return     发送长度，失败返回-1
+*/
+static int
+LogTransportSend(int fd, const char* data, int len, int wait_us)
+{
+    union {
+        struct sockaddr_in  in;
+        struct sockaddr_un  un;
+    } addr;
+    struct timeval tv = {0, wait_us};
+    socklen_t addr_len;
+
+    if (log_transport == LOG_TRANSPORT_SHM) {
+        return (ShmQueuePush(log_shm, data, len, &tv) == 0) ? len : -1;
+    }
+    addr_len = LogTransportAddr(&addr);
+    return sendto(fd, data, len, 0, (struct sockaddr* )&addr, addr_len);
+}
+
+/*
+* @brief      选择日志传输方式
+* @note       在LogInit前后、启动异步日志前调用；共享内存队列由守护进程创建，
+*             打开失败时返回失败且不改变当前方式，调用者可继续使用udp
+* @param[in]  transport   传输方式
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+int
+LogSetTransport(LogTransportEnum transport)
+{
+    if ((transport >= LOG_TRANSPORT_MAX) || log_async.running) {
+        return -1;
+    }
+    if ((transport == LOG_TRANSPORT_SHM) && (log_shm == NULL)) {
+        log_shm = ShmQueueOpen(LOG_SHM_NAME, 0, 0);
+        if (log_shm == NULL) {
+            return -1;
+        }
+    }
+
+    /* 已创建的socket按新方式重新创建 */
+    log_transport = transport;
+    if (log_fd >= 0) {
+        close(log_fd);
+        log_fd = -1;
+    }
+    if (log_async.fd >= 0) {
+        close(log_async.fd);
+        log_async.fd = -1;
+    }
+    return 0;
+}
+
 
 /*
 * @brief      格式化字符串(可变参数)
@@ -142,74 +374,814 @@ LogFormatString(char *str, int size, const char *format, ...)
 }
 
 /*
-* @brief      打印日志(可变参数)
-* @note
+* @brief      线程退出时标记缓冲区
+* @note       缓冲区由后台线程读空后释放
+* @param[in]  arg     线程缓冲区
+* @return     无
+*/
+static void
+LogRingOrphan(void* arg)
+{
+    __atomic_store_n(&(((LogRingData* )arg)->orphan), 1, __ATOMIC_RELEASE);
+}
+
+/*
+* @brief      fork后子进程复位异步日志和调用点登记
+* @note       子进程中没有后台线程，继承的缓冲区无人读取；全部释放后子进程同步发送，
+*             需要异步时由子进程再调用LogAsyncStart；父进程未发出的记录由父进程发送；
+*             守护进程按(进程ID, 编号)查找调用点，子进程用自己的进程ID重新登记
+* @return     无
+*/
+static void
+LogAtforkChild(void)
+{
+    int i;
+
+    pthread_mutex_init(&log_site_lock, NULL);
+    log_site_epoch++;
+
+    log_async.running = 0;
+    log_async.sleeping = 0;
+    for (i = 0; i < log_async.ring_number; i++) {
+        free(log_async.rings[i]->buf);
+        free(log_async.rings[i]);
+    }
+    log_async.ring_number = 0;
+    pthread_mutex_init(&(log_async.lock), NULL);
+    if (log_tls_ring != NULL) {
+        pthread_setspecific(log_ring_key, NULL);
+        log_tls_ring = NULL;
+    }
+    memset(&log_batch, 0, sizeof(log_batch));
+    if (log_async.fd >= 0) {
+        close(log_async.fd);
+        log_async.fd = -1;
+    }
+    if (log_fd >= 0) {
+        close(log_fd);
+        log_fd = -1;
+    }
+}
+
+static void
+LogAtforkInit(void)
+{
+    pthread_atfork(NULL, NULL, LogAtforkChild);
+}
+
+static void
+LogRingKeyCreate(void)
+{
+    pthread_key_create(&log_ring_key, LogRingOrphan);
+    pthread_once(&log_atfork_once, LogAtforkInit);
+}
+
+/*
+* @brief      为当前线程创建并登记缓冲区
+* @note       失败时本线程记为log_ring_none，之后不再重试
+* @return     缓冲区指针，失败返回NULL
+*/
+static LogRingData*
+LogRingRegister(void)
+{
+    LogRingData* r = NULL;
+    uint32_t size = 1024;
+
+    /* 取2的幂，至少容纳几条最长记录 */
+    while ((size < (uint32_t)log_async.ring_size) || (size < 4 * (MAX_LOG_RECORD_LEN + sizeof(LogRecordHead)))) {
+        size <<= 1;
+    }
+    if (posix_memalign((void** )&r, LOG_CACHE_LINE_SIZE, sizeof(LogRingData)) != 0) {
+        log_tls_ring = &log_ring_none;
+        return NULL;
+    }
+    r->buf = (char* )malloc(size);
+    if (r->buf == NULL) {
+        free(r);
+        log_tls_ring = &log_ring_none;
+        return NULL;
+    }
+    r->mask = size - 1;
+    r->pid = getpid();
+    r->tid = syscall(SYS_gettid);
+    r->orphan = 0;
+    r->head = r->tail = 0;
+
+    pthread_mutex_lock(&(log_async.lock));
+    if (log_async.ring_number >= LOG_ASYNC_MAX_THREADS) {
+        pthread_mutex_unlock(&(log_async.lock));
+        free(r->buf);
+        free(r);
+        log_tls_ring = &log_ring_none;
+        return NULL;
+    }
+    log_async.rings[log_async.ring_number++] = r;
+    pthread_mutex_unlock(&(log_async.lock));
+
+    pthread_setspecific(log_ring_key, r);
+    log_tls_ring = r;
+    return r;
+}
+
+/*
+* @brief      预留一条记录的空间
+* @note       尾部连续空间不足时写入填充记录回绕到开头；预留的空间在提交前对后台线程不可见
+* @param[in]  r       线程缓冲区
+* @param[in]  size    最大文本长度
+* @param[out] pos     记录起始下标
+* @return     记录头指针，空间不足返回NULL
+*/
+static LogRecordHead*
+LogRingReserve(LogRingData* r, uint32_t size, uint32_t* pos)
+{
+    uint32_t need = LOG_ALIGN(sizeof(LogRecordHead) + size);
+    uint32_t tail = r->tail, head = __atomic_load_n(&(r->head), __ATOMIC_ACQUIRE);
+    uint32_t rest = r->mask + 1 - (tail & r->mask);
+
+    if (rest < need) {
+        if (tail + rest + need - head > r->mask + 1) {
+            return NULL;
+        }
+        ((LogRecordHead* )(r->buf + (tail & r->mask)))->len = 0;
+        tail += rest;
+    } else if (tail + need - head > r->mask + 1) {
+        return NULL;
+    }
+    *pos = tail;
+    return (LogRecordHead* )(r->buf + (tail & r->mask));
+}
+
+/*
+* @brief      唤醒休眠的后台线程
+* @note       后台线程未休眠时只有一次读，不做系统调用
+* @return     无
+*/
+static void
+LogAsyncWake(void)
+{
+    if (__atomic_load_n(&(log_async.sleeping), __ATOMIC_SEQ_CST) &&
+        __atomic_exchange_n(&(log_async.sleeping), 0, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &(log_async.sleeping), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+/*
+* @brief      提交记录
+* @note       一次写使填充和记录同时对后台线程可见；写下标与读sleeping之间需全屏障，
+*             与后台线程先置sleeping再检查缓冲区配对，不会漏掉唤醒
+* @param[in]  r       线程缓冲区
+* @param[in]  pos     记录起始下标
+* @param[in]  rec     记录头，len已填写
+* @return     无
+*/
+static void
+LogRingCommit(LogRingData* r, uint32_t pos, const LogRecordHead* rec)
+{
+    __atomic_store_n(&(r->tail), pos + LOG_ALIGN(sizeof(LogRecordHead) + rec->len), __ATOMIC_SEQ_CST);
+    LogAsyncWake();
+}
+
+/*
+* @brief      同步发送一条记录
+* @note       调用者线程中发送，共享内存队列满时不等待，直接丢弃并计数
+* @param[in]  fd      发送socket
+* @param[in]  data    记录
+* @param[in]  len     记录长度
+* @return     无
+*/
+static void
+LogSendSync(int fd, const char* data, int len)
+{
+    if (LogTransportSend(fd, data, len, 0) > 0) {
+        return;
+    }
+    if (log_transport == LOG_TRANSPORT_SHM) {
+        __atomic_add_fetch(&log_shm_dropped, 1, __ATOMIC_RELAXED);
+    } else {
+        perror("send log error");
+    }
+}
+
+/*
+* @brief      输出一条已格式化的日志
+* @note       按flag打印到命令行和发送给守护进程
+* @param[in]  fd      发送socket
+* @param[in]  level   日志级别
+* @param[in]  flag    打印标识
+* @param[in]  data    文本记录，记录头后为日志文本
+* @param[in]  len     记录长度
+* @return     无
+*/
+static void
+LogEmit(int fd, int level, int flag, const char* data, int len)
+{
+    if (flag > QUIT) {
+        if (flag != ONLY_WRITE) {
+            PRINTF_COLOR(log_level_color[level], data + sizeof(LogBinHead));
+        }
+        if (flag > ONLY_READ) {
+            LogSendSync(fd, data, len);
+        }
+    }
+}
+
+/*
+* @brief      发出已合并的数据报
+* @note       sendmmsg可能只发出一部分，循环到全部发出或出错
+* @param[in]  fd      发送socket
+* @return     无
+*/
+static void
+LogBatchFlush(int fd)
+{
+    LogBatchData* b = &log_batch;
+    int count = b->number + ((b->iovs[b->number].iov_len > 0) ? 1 : 0), sent = 0, ret;
+
+    /* 共享内存方式每个数据报写一条队列记录，后台线程可以等待守护进程腾出空间 */
+    if (log_transport == LOG_TRANSPORT_SHM) {
+        for (sent = 0; sent < count; sent++) {
+            if (LogTransportSend(fd, b->bufs[sent], b->iovs[sent].iov_len, LOG_SHM_WAIT_US) < 0) {
+                __atomic_add_fetch(&log_shm_dropped, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    while (sent < count) {
+        ret = sendmmsg(fd, b->msgs + sent, count - sent, 0);
+        if (ret <= 0) {
+            if ((ret < 0) && (errno == EINTR)) {
+                continue;
+            }
+            perror("send log error");
+            break;
+        }
+        sent += ret;
+    }
+    for (ret = 0; ret < count; ret++) {
+        b->iovs[ret].iov_len = 0;
+    }
+    b->number = 0;
+}
+
+/*
+* @brief      记录加入发送批次
+* @note       当前数据报放不下时换下一个，全部写满先发出
+* @param[in]  fd      发送socket
+* @param[in]  data    记录
+* @param[in]  len     记录长度
+* @return     无
+*/
+static void
+LogBatchAppend(int fd, const char* data, int len)
+{
+    LogBatchData* b = &log_batch;
+    struct iovec* iov = &(b->iovs[b->number]);
+    socklen_t addr_len;
+    int i;
+
+    if (b->msgs[0].msg_hdr.msg_iov == NULL) {
+        addr_len = LogTransportAddr(&(b->addr));
+        for (i = 0; i < LOG_BATCH_NUMBER; i++) {
+            b->iovs[i].iov_base = b->bufs[i];
+            b->iovs[i].iov_len = 0;
+            b->msgs[i].msg_hdr.msg_name = &(b->addr);
+            b->msgs[i].msg_hdr.msg_namelen = addr_len;
+            b->msgs[i].msg_hdr.msg_iov = &(b->iovs[i]);
+            b->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        iov = &(b->iovs[0]);
+    }
+
+    if (iov->iov_len + len > LOG_BATCH_SIZE) {
+        if (b->number == LOG_BATCH_NUMBER - 1) {
+            LogBatchFlush(fd);
+        } else {
+            b->number++;
+        }
+        iov = &(b->iovs[b->number]);
+    }
+    memcpy((char* )iov->iov_base + iov->iov_len, data, len);
+    iov->iov_len += len;
+}
+
+/*
+* @brief      后台线程输出一条记录
+* @note       命令行直接打印，发给守护进程的先合并；二进制记录总是ONLY_WRITE，不会打印
+* @param[in]  level   日志级别
+* @param[in]  flag    打印标识
+* @param[in]  data    文本记录或二进制记录
+* @param[in]  len     记录长度
+* @return     无
+*/
+static void
+LogBatchEmit(int level, int flag, const char* data, int len)
+{
+    if (flag > QUIT) {
+        if (flag != ONLY_WRITE) {
+            PRINTF_COLOR(log_level_color[level], data + sizeof(LogBinHead));
+        }
+        if (flag > ONLY_READ) {
+            LogBatchAppend(log_async.fd, data, len);
+        }
+    }
+}
+
+/*
+* @brief      读空一个线程缓冲区
+* @note       读完一批后只更新一次读下标，记录已拷贝进发送批次
+* @param[in]  r       线程缓冲区
+* @return     读出条数
+*/
+static int
+LogRingDrain(LogRingData* r)
+{
+    uint32_t head = r->head, tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);
+    LogRecordHead* rec;
+    int count = 0;
+
+    while (head != tail) {
+        rec = (LogRecordHead* )(r->buf + (head & r->mask));
+        if (rec->len == 0) {
+            head += r->mask + 1 - (head & r->mask);
+            continue;
+        }
+        LogBatchEmit(rec->level, rec->flag, (const char* )(rec + 1), rec->len);
+        head += LOG_ALIGN(sizeof(LogRecordHead) + rec->len);
+        count++;
+    }
+    __atomic_store_n(&(r->head), head, __ATOMIC_RELEASE);
+    return count;
+}
+
+/*
+* @brief      读空所有线程缓冲区
+* @note       持锁只拷贝缓冲区列表，读取和发送在锁外进行，首次写日志的线程登记时不必等待发送；
+*             只有后台线程删除和释放缓冲区，拷贝出的指针在本轮内有效
+* @return     读出条数
+*/
+static int
+LogAsyncDrainAll(void)
+{
+    LogRingData* rings[LOG_ASYNC_MAX_THREADS];
+    LogRingData* orphans[LOG_ASYNC_MAX_THREADS];
+    int number, orphan_number = 0, count = 0, i, j;
+
+    pthread_mutex_lock(&(log_async.lock));
+    number = log_async.ring_number;
+    memcpy(rings, log_async.rings, number * sizeof(LogRingData* ));
+    pthread_mutex_unlock(&(log_async.lock));
+
+    for (i = 0; i < number; i++) {
+        /* 先读退出标记再读空，之后该线程不会再写入 */
+        if (__atomic_load_n(&(rings[i]->orphan), __ATOMIC_ACQUIRE)) {
+            orphans[orphan_number++] = rings[i];
+        }
+        count += LogRingDrain(rings[i]);
+    }
+
+    if (orphan_number > 0) {
+        pthread_mutex_lock(&(log_async.lock));
+        for (i = 0; i < orphan_number; i++) {
+            for (j = 0; j < log_async.ring_number; j++) {
+                if (log_async.rings[j] == orphans[i]) {
+                    log_async.rings[j] = log_async.rings[--log_async.ring_number];
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&(log_async.lock));
+        for (i = 0; i < orphan_number; i++) {
+            free(orphans[i]->buf);
+            free(orphans[i]);
+        }
+    }
+    return count;
+}
+
+/*
+* @brief      是否有未读的记录
+* @note       后台线程置sleeping后调用，持锁保证看到刚登记的缓冲区
+* @return     1有，0没有
+*/
+static int
+LogAsyncPending(void)
+{
+    int pending = 0, i;
+
+    pthread_mutex_lock(&(log_async.lock));
+    for (i = 0; (i < log_async.ring_number) && !pending; i++) {
+        pending = (__atomic_load_n(&(log_async.rings[i]->tail), __ATOMIC_SEQ_CST) != log_async.rings[i]->head);
+    }
+    pthread_mutex_unlock(&(log_async.lock));
+    return pending;
+}
+
+/*
+* @brief      后台发送线程
+* @note       读空各线程缓冲区后在futex上休眠，生产者提交记录时唤醒；最长休眠LOG_ASYNC_PARK_MS，
+*             用于回收已退出线程的缓冲区；停止时读空后退出
+* @param[in]  arg     未使用
+* @return     NULL
+*/
+static void*
+LogAsyncThread(void* arg)
+{
+    struct timespec park = {LOG_ASYNC_PARK_MS / 1000, (LOG_ASYNC_PARK_MS % 1000) * 1000000};
+    unsigned long reported = 0, dropped;
+    char notice[sizeof(LogBinHead) + 128];
+    int len, count;
+
+    (void)arg;
+    for (;;) {
+        count = LogAsyncDrainAll();
+
+        dropped = __atomic_load_n(&(log_async.dropped), __ATOMIC_RELAXED);
+        if (dropped != reported) {
+            len = snprintf(notice + sizeof(LogBinHead), sizeof(notice) - sizeof(LogBinHead),
+                           "[%c][PID:%d]async log dropped %lu records",
+                           log_level_char[WARNING], getpid(), dropped - reported);
+            len = LogBinaryEncodeText(notice, WARNING, getpid(), 0, LogBinaryTime(), len + 1);
+            LogBatchEmit(WARNING, ONLY_WRITE, notice, len);
+            reported = dropped;
+        }
+
+        /* 一轮读完即发出，不跨越空闲休眠积压 */
+        LogBatchFlush(log_async.fd);
+
+        if (count > 0) {
+            continue;
+        }
+        if (!__atomic_load_n(&(log_async.running), __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        /* 先声明休眠再检查一遍，之后提交的记录一定会唤醒 */
+        __atomic_store_n(&(log_async.sleeping), 1, __ATOMIC_SEQ_CST);
+        if (!LogAsyncPending() && __atomic_load_n(&(log_async.running), __ATOMIC_SEQ_CST)) {
+            syscall(SYS_futex, &(log_async.sleeping), FUTEX_WAIT_PRIVATE, 1, &park, NULL, 0);
+        }
+        __atomic_store_n(&(log_async.sleeping), 0, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*
+* @brief      异步写入一条日志
+* @note       直接格式化到本线程缓冲区，调用者不做系统调用；本线程没有缓冲区时不使用vp，由调用者同步发送
 * @param[in]  file    代码文件名
+* @param[in]  func    函数名
 * @param[in]  line    代码行数
 * @param[in]  level   日志级别
 * @param[in]  log_id  模块ID
+* @param[in]  flag    打印标识
 * @param[in]  format  格式化的字符串
+* @param[in]  vp      可变参数
+* @return     执行结果
+* @retval     0       已写入缓冲区或已丢弃
+* @retval     -1      本线程没有缓冲区
+*/
+static int
+LogAsyncWrite(const char* file, const char* func, int line, LogLevelEnum level, const char* log_id, int flag, const char* format, va_list vp)
+{
+    LogRingData* r = log_tls_ring;
+    LogRecordHead* rec;
+    uint64_t event_time = LogBinaryTime();
+    uint32_t pos;
+    char* text;
+    int len, size = MAX_LOG_RECORD_LEN - sizeof(LogBinHead);
+
+    if ((r == &log_ring_none) || ((r == NULL) && ((r = LogRingRegister()) == NULL))) {
+        return -1;
+    }
+    rec = LogRingReserve(r, MAX_LOG_RECORD_LEN, &pos);
+    if (rec == NULL) {
+        __atomic_add_fetch(&(log_async.dropped), 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    /* 文本写在记录头之后，整条文本记录不超过MAX_LOG_RECORD_LEN */
+    text = (char* )(rec + 1) + sizeof(LogBinHead);
+    len = snprintf(text, size, "[%c][PID:%d TID:%ld][%s %s][LINE:%d]%s->:",
+                   log_level_char[level], r->pid, r->tid, file, func, line, log_id);
+    if (len < size) {
+        len += vsnprintf(text + len, size - len, format, vp);
+    }
+    if (len >= size) {
+        len = size - 1;
+    }
+
+    /* 关键字过滤，不提交即丢弃 */
+    if ((log_ft.keyword[0] != '\0') && !strstr(text, log_ft.keyword)) {
+        return 0;
+    }
+
+    rec->len = LogBinaryEncodeText((char* )(rec + 1), level, r->pid, r->tid, event_time, len + 1);
+    rec->level = level;
+    rec->flag = flag;
+    LogRingCommit(r, pos, rec);
+    return 0;
+}
+
+/*
+* @brief      异步写入一条二进制日志
+* @note       只把参数原始值编码到本线程缓冲区；本线程没有缓冲区时不使用vp，由调用者同步发送
+* @param[in]  site    已登记的调用点
+* @param[in]  vp      可变参数
+* @return     执行结果
+* @retval     0       已写入缓冲区或已丢弃
+* @retval     -1      本线程没有缓冲区
+*/
+static int
+LogAsyncWriteBinary(const LogSite* site, va_list vp)
+{
+    LogRingData* r = log_tls_ring;
+    LogRecordHead* rec;
+    uint32_t pos;
+    int len;
+
+    if ((r == &log_ring_none) || ((r == NULL) && ((r = LogRingRegister()) == NULL))) {
+        return -1;
+    }
+    rec = LogRingReserve(r, MAX_LOG_RECORD_LEN, &pos);
+    if (rec == NULL) {
+        __atomic_add_fetch(&(log_async.dropped), 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    len = LogBinaryEncode((char* )(rec + 1), MAX_LOG_RECORD_LEN, site, r->pid, r->tid, vp);
+    if (len < 0) {
+        return 0;
+    }
+    rec->len = len;
+    rec->level = site->level;
+    rec->flag = site->flag;
+    LogRingCommit(r, pos, rec);
+    return 0;
+}
+
+/*
+* @brief      启动异步日志
+* @note       启动后Log()只把记录写入本线程的环形缓冲区，由后台线程发送；缓冲区满时丢弃并计数
+* @param[in]  ring_size   每线程缓冲区大小，取2的幂，<=0使用默认值
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+int
+LogAsyncStart(int ring_size)
+{
+    if (log_async.running) {
+        return 0;
+    }
+    pthread_once(&log_ring_once, LogRingKeyCreate);
+    log_async.ring_size = (ring_size > 0) ? ring_size : LOG_ASYNC_RING_SIZE;
+    if ((log_async.fd < 0) && (LogTransportOpen(&(log_async.fd)) != 0)) {
+        log_async.fd = -1;
+        return -1;
+    }
+    /* 传输方式可能已改变，发送批次重新初始化 */
+    memset(&log_batch, 0, sizeof(log_batch));
+
+    __atomic_store_n(&(log_async.running), 1, __ATOMIC_RELEASE);
+    if (pthread_create(&(log_async.thread), NULL, LogAsyncThread, NULL) != 0) {
+        __atomic_store_n(&(log_async.running), 0, __ATOMIC_RELEASE);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* @brief      停止异步日志
+* @note       发送完缓冲区中的记录后返回，之后Log()恢复同步发送；
+*             停止过程中其他线程仍在写入的记录留在缓冲区，下次启动时发送
 * @return     无
 */
-void 
-Log(const char* file, const char* func, int line, LogLevelEnum level, const char* log_id, int flag, const char* format, ...)
+void
+LogAsyncStop(void)
 {
-    if ((level < log_ft.level) || (ENABLE_OUTPUT_CMD_FILE < flag)) {
+    if (!log_async.running) {
+        return;
+    }
+    __atomic_store_n(&(log_async.running), 0, __ATOMIC_SEQ_CST);
+    LogAsyncWake();
+    pthread_join(log_async.thread, NULL);
+}
+
+/*
+* @brief      异步日志丢弃条数
+* @note       线程缓冲区满时丢弃；线程数超过上限时该线程改为同步发送，不计入
+* @return     丢弃条数
+*/
+unsigned long
+LogAsyncDropped(void)
+{
+    return __atomic_load_n(&(log_async.dropped), __ATOMIC_RELAXED);
+}
+
+/*
+* @brief      共享内存队列满丢弃条数
+* @note       同步发送时队列满不等待直接丢弃；后台线程最多等待LOG_SHM_WAIT_US后丢弃
+* @return     丢弃条数
+*/
+unsigned long
+LogShmDropped(void)
+{
+    return __atomic_load_n(&log_shm_dropped, __ATOMIC_RELAXED);
+}
+
+/*
+* @brief      准备同步发送端
+* @note       首次使用时创建socket，共享内存方式不需要socket
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+static int
+LogSocket(void)
+{
+    int fd = -1;
+
+    if ((log_fd < 0) && (log_transport != LOG_TRANSPORT_SHM)) {
+        if (LogTransportOpen(&fd) != 0) {
+            return -1;
+        }
+        log_fd = fd;
+    }
+    return (log_transport == LOG_TRANSPORT_SHM) ? LogTransportOpen(&fd) : 0;
+}
+
+/*
+* @brief      打印日志(va_list)，不再过滤级别和标签
+* @note       按是否启动异步日志选择写缓冲区或直接发送，本线程没有缓冲区时直接发送
+* @param[in]  file    代码文件名
+* @param[in]  func    函数名
+* @param[in]  line    代码行数
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @param[in]  flag    打印标识
+* @param[in]  format  格式化的字符串
+* @param[in]  vp      可变参数
+* @return     无
+*/
+static void
+LogWriteV(const char* file, const char* func, int line, LogLevelEnum level, const char* log_id, int flag, const char* format, va_list vp)
+{
+    if ((level >= LEVEL_MAX) || (ENABLE_OUTPUT_CMD_FILE < flag)) {
         return;  
     } 
-    
-    /* 标签过滤 */
-    if (log_ft.tag[0] != '\0') {
-        if (strcmp(log_id, log_ft.tag)) {
-            return;
-        }
+
+    if (__atomic_load_n(&(log_async.running), __ATOMIC_ACQUIRE) &&
+        (LogAsyncWrite(file, func, line, level, log_id, flag, format, vp) == 0)) {
+        return;
     }
 
-    int ret = -1;
-    static int s_fd = -1;
-    if (s_fd <= 0) {
-        ret = LogCreateInetDgramSocket(&s_fd, NULL, 0);
-        if (ret != 0) {
-            s_fd = -1;
-            return;
-        }
+    if (LogSocket() != 0) {
+        return;
     }
+    uint64_t event_time = LogBinaryTime();
     char buf[MAX_COM_BUF_LEN] = {0}, out_buf[MAX_COM_BUF_LEN] = {0};
+    char* text = out_buf + sizeof(LogBinHead);
+    long tid = syscall(SYS_gettid);
+    int len;
 
-    va_list vp;
-    va_start(vp, format);
     vsnprintf(buf, MAX_COM_BUF_LEN, format, vp);
-    va_end(vp);
     
-    char array_level[LEVEL_MAX]={'V', 'D', 'I', 'W', 'E', 'A'};
-    if (level >= LEVEL_MAX) {
-        return;
-    }
-    /* 日志等级格式化 */
-    snprintf(out_buf, MAX_COM_BUF_LEN, "[%c][PID:%d TID:%ld][%s %s][LINE:%d]%s->:%s", array_level[level], getpid(), syscall(SYS_gettid), file, func, line, log_id, buf);
+    /* 日志等级格式化，文本写在记录头之后 */
+    snprintf(text, MAX_COM_BUF_LEN - sizeof(LogBinHead), "[%c][PID:%d TID:%ld][%s %s][LINE:%d]%s->:%s", log_level_char[level], getpid(), tid, file, func, line, log_id, buf);
 
     /* 关键字过滤 */
     if (log_ft.keyword[0] != '\0') {
-        if (!strstr(out_buf, log_ft.keyword)) {
+        if (!strstr(text, log_ft.keyword)) {
             return;
         }
     }
 
     /* 日志实时开关控制 */
-    char *array_level_color[LEVEL_MAX] = {PRT_VERBOSE, PRT_DEBUG, PRT_INFO, PRT_WARNING, PRT_ERROR, PRT_ASSERT};
-    if (flag > QUIT) {
-        if (flag != ONLY_WRITE) {
-            PRINTF_COLOR(array_level_color[level], out_buf);
-        } 
-        if (flag > ONLY_READ) {
-            ret = LogSendInetDgramSocket(s_fd, LOCAL_INET_ADDR, LOG_UDP_PORT, out_buf, (strlen(out_buf) + 1));
-            if (ret <= 0) {
-                perror("send log error");
+    len = LogBinaryEncodeText(out_buf, level, getpid(), tid, event_time, strlen(text) + 1);
+    LogEmit(log_fd, level, flag, out_buf, len);
+
+    return;
+}
+
+/*
+* @brief      打印日志(可变参数)
+* @note
+* @param[in]  file    代码文件名
+* @param[in]  line    代码行数
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @param[in]  format  格式化的字符串
+* @return     无
+*/
+void 
+Log(const char* file, const char* func, int line, LogLevelEnum level, const char* log_id, int flag, const char* format, ...)
+{
+    va_list vp;
+
+    if (!LogEnabled(level, log_id)) {
+        return;
+    }
+    va_start(vp, format);
+    LogWriteV(file, func, line, level, log_id, flag, format, vp);
+    va_end(vp);
+}
+
+/*
+* @brief      打印日志(可变参数)，不再过滤
+* @note       由LOG宏在过滤通过后调用，关键字过滤仍需格式化后进行
+* @param[in]  file    代码文件名
+* @param[in]  line    代码行数
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @param[in]  format  格式化的字符串
+* @return     无
+*/
+void
+LogWrite(const char* file, const char* func, int line, LogLevelEnum level, const char* log_id, int flag, const char* format, ...)
+{
+    va_list vp;
+
+    va_start(vp, format);
+    LogWriteV(file, func, line, level, log_id, flag, format, vp);
+    va_end(vp);
+}
+
+/*
+* @brief      登记调用点
+* @note       首次登记时解析格式串并分配编号；把调用点描述同步发给守护进程，之后才发布版本，
+*             保证守护进程先收到登记再收到参数记录；udp发送成功不代表守护进程收到，
+*             登记丢失后该调用点的记录都无法解码，因此udp方式退回文本日志；
+*             守护进程重启后调用点表为空，每LOG_BIN_REFRESH_SEC重新发送一次登记
+* @param[in]  site    调用点
+* @param[in]  now     当前单调时间，秒
+* @return     执行结果
+* @retval     0       成功，调用点不支持二进制时也返回0
+* @retval     -1      发送失败，本条记录退回文本日志，下次调用重试
+*/
+static int
+LogSiteRegister(LogSite* site, uint32_t now)
+{
+    char buf[MAX_LOG_RECORD_LEN];
+    int len, ret = 0;
+
+    pthread_once(&log_atfork_once, LogAtforkInit);
+    pthread_mutex_lock(&log_site_lock);
+    if (site->id == 0) {
+        LogBinaryParse(site);
+        if (log_transport == LOG_TRANSPORT_UDP) {
+            site->arg_number = -1;
+        }
+        site->id = ++log_site_number;
+    }
+    if ((site->epoch != log_site_epoch) || (now - site->registered >= LOG_BIN_REFRESH_SEC)) {
+        if (site->arg_number >= 0) {
+            len = LogBinaryEncodeSite(buf, sizeof(buf), site, getpid());
+            if ((len < 0) || (LogSocket() != 0) || (LogTransportSend(log_fd, buf, len, 0) != len)) {
+                ret = -1;
             }
         }
+        if (ret == 0) {
+            __atomic_store_n(&(site->registered), now, __ATOMIC_RELAXED);
+            __atomic_store_n(&(site->epoch), log_site_epoch, __ATOMIC_RELEASE);
+        }
     }
+    pthread_mutex_unlock(&log_site_lock);
+    return ret;
+}
 
-    return;
+/*
+* @brief      打印二进制日志(可变参数)
+* @note       由LOG_BIN宏在过滤通过后调用；只对写文件的日志生效：只拷贝参数，由守护进程格式化；
+*             需要打印命令行、格式串不支持或调用点登记失败时退回文本日志，关键字过滤不作用于二进制日志
+* @param[in]  site    调用点
+* @return     无
+*/
+void
+LogBinary(LogSite* site, ...)
+{
+    char buf[MAX_LOG_RECORD_LEN];
+    struct timespec now;
+    va_list vp;
+    int len, ret = 0;
+
+    if ((site->level >= LEVEL_MAX) || (ENABLE_OUTPUT_CMD_FILE < site->flag)) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    if ((__atomic_load_n(&(site->epoch), __ATOMIC_ACQUIRE) != __atomic_load_n(&log_site_epoch, __ATOMIC_RELAXED)) ||
+        ((uint32_t)now.tv_sec - __atomic_load_n(&(site->registered), __ATOMIC_RELAXED) >= LOG_BIN_REFRESH_SEC)) {
+        ret = LogSiteRegister(site, now.tv_sec);
+    }
+
+    va_start(vp, site);
+    if ((ret != 0) || (site->arg_number < 0) || (site->flag != ONLY_WRITE)) {
+        LogWriteV(site->file, site->func, site->line, site->level, site->log_id, site->flag, site->format, vp);
+    } else if (!__atomic_load_n(&(log_async.running), __ATOMIC_ACQUIRE) ||
+               (LogAsyncWriteBinary(site, vp) != 0)) {
+        len = LogBinaryEncode(buf, sizeof(buf), site, getpid(), syscall(SYS_gettid), vp);
+        if ((len > 0) && (LogSocket() == 0)) {
+            LogSendSync(log_fd, buf, len);
+        }
+    }
+    va_end(vp);
 }
 
 /*
@@ -39,6 +39,8 @@ extern "C"
 #include <netinet/tcp.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
+#include <pthread.h>
+#include "logBinary.h"
 
 
 /* #pragma once 
@@ -59,6 +61,16 @@ typedef enum {
     LEVEL_MAX,      
 }LogLevelEnum;
 
+/*
+* @brief 日志传输方式
+*/
+typedef enum {
+    LOG_TRANSPORT_UDP,       /* 本地回环udp，默认，LOG_BIN退回文本日志 */
+    LOG_TRANSPORT_UNIX,      /* AF_UNIX数据报，守护进程来不及接收时发送方阻塞而不是丢弃 */
+    LOG_TRANSPORT_SHM,       /* 共享内存环形队列，守护进程不等待时不经过系统调用 */
+    LOG_TRANSPORT_MAX,
+}LogTransportEnum;
+
     //---- 枚举结束 ----//
 
     //---- 宏定义开始 ----//
@@ -70,6 +82,18 @@ typedef enum {
 #define MAX_FILTER_NAME_LEN       15              /* 最大过滤长度 */
 #define LOCAL_INET_ADDR           "127.0.0.1"     /* 本地内部地址，内部通信 */
 #define INET_RX_ADDR              "0.0.0.0"       /* 本地所有IP地址 */
+#define MAX_LOG_RECORD_LEN        4096            /* 单条日志最大长度，与守护进程一致 */
+#define LOG_UNIX_PATH             "/tmp/avic_log.sock"   /* AF_UNIX传输地址，与守护进程一致 */
+#define LOG_SHM_NAME              "/avic_log"     /* 共享内存传输名称，与守护进程一致 */
+#define LOG_SHM_WAIT_US           10000           /* 共享内存队列满时后台线程最多等待时间，同步发送不等待 */
+#define LOG_BIN_REFRESH_SEC       1               /* 二进制日志调用点重新登记周期，守护进程重启后最多丢失该时长的记录 */
+
+/* 异步日志 */
+#define LOG_ASYNC_RING_SIZE       (256 * 1024)    /* 每线程环形缓冲区默认大小 */
+#define LOG_ASYNC_MAX_THREADS     64              /* 最多登记的线程数，之后的线程同步发送 */
+#define LOG_ASYNC_PARK_MS         1000            /* 后台线程空闲时最长休眠时间，有新记录时被唤醒 */
+#define LOG_BATCH_SIZE            (32 * 1024)     /* 后台线程合并后单个数据报最大长度 */
+#define LOG_BATCH_NUMBER          8               /* 一次sendmmsg最多发送的数据报个数 */
 
 /* 日志flag控制 */
 #define DISABLE_OUTPUT 				0               
@@ -122,7 +146,30 @@ typedef enum {
 
 #define PRINTF_COLOR(prt_color, string)       printf("%s%s%s%s\n", START, prt_color, string, END)
 
-#define LOG(level, id, flag, fmt, args...)    Log((const char* )__FILE__, (const char* )__FUNCTION__, __LINE__, level, id, flag, fmt, ##args)
+/* 编译期最低日志级别，低于该级别的LOG/LOG_BIN整段代码被编译器删除，如-DLOG_MIN_LEVEL=INFO */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL             VERBOSE
+#endif
+
+/* 级别和模块ID为常量时过滤结果缓存在调用点，LogInit修改过滤条件后失效；否则每次比较 */
+#define LOG(level, id, flag, fmt, args...)                                                        \
+    do {                                                                                           \
+        static uint32_t log_cache_ = 0;                                                            \
+        if (((level) >= LOG_MIN_LEVEL) &&                                                          \
+            ((__builtin_constant_p(level) && __builtin_constant_p(id)) ?                           \
+             LogCacheEnabled(&log_cache_, level, id) : LogEnabled(level, id))) {                   \
+            LogWrite((const char* )__FILE__, (const char* )__FUNCTION__, __LINE__, level, id, flag, fmt, ##args); \
+        }                                                                                          \
+    } while (0)
+
+/* 二进制日志：调用点静态登记一次，之后只拷贝参数，由守护进程格式化 */
+#define LOG_BIN(level, id, flag, fmt, args...)                                                    \
+    do {                                                                                           \
+        static LogSite log_site_ = {__FILE__, __FUNCTION__, __LINE__, level, id, flag, fmt, 0, 0, {0}, {0}, 0, 0, 0}; \
+        if (((level) >= LOG_MIN_LEVEL) && LogCacheEnabled(&(log_site_.cache), level, id)) {        \
+            LogBinary(&log_site_, ##args);                                                         \
+        }                                                                                          \
+    } while (0)
 
 #define LOG_BUF LogBuf
 
@@ -144,6 +191,8 @@ typedef struct {
 
     /* ---- 函数声明开始 ---- */
 
+extern uint32_t log_filter_generation;                        /* 过滤条件版本，每次LogInit加2 */
+
 /*
   * @brief      日志等级
   * @note       小于等级level的日志信息将被过滤,默认为0
@@ -189,6 +238,66 @@ int LogFormatString(char* , int , const char* , ...);
 */
 void Log(const char* , const char* , int , LogLevelEnum , const char* , int , const char* , ...);       
 
+/*
+* @brief      判断日志是否通过级别和标签过滤
+* @note
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @return     1通过，0过滤
+*/
+int LogEnabled(int , const char* );
+
+/*
+* @brief      重新计算调用点过滤结果
+* @note       缓存值为过滤条件版本加是否通过，版本为偶数
+* @param[out] cache   调用点缓存
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @return     1通过，0过滤
+*/
+int LogCacheRefresh(uint32_t* , int , const char* );
+
+/*
+* @brief      读取调用点过滤结果
+* @note       版本未变时直接返回缓存结果
+* @param[in]  cache   调用点缓存
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @return     1通过，0过滤
+*/
+static inline int
+LogCacheEnabled(uint32_t* cache, int level, const char* log_id)
+{
+    uint32_t value = __atomic_load_n(cache, __ATOMIC_RELAXED);
+
+    if ((value & ~1u) == __atomic_load_n(&log_filter_generation, __ATOMIC_RELAXED)) {
+        return value & 1;
+    }
+    return LogCacheRefresh(cache, level, log_id);
+}
+
+/*
+* @brief      打印日志(可变参数)，不再过滤
+* @note       由LOG宏在过滤通过后调用，关键字过滤仍需格式化后进行
+* @param[in]  file    代码文件名
+* @param[in]  line    代码行数
+* @param[in]  level   日志级别
+* @param[in]  log_id  模块ID
+* @param[in]  format  格式化的字符串
+* @return     无
+*/
+void LogWrite(const char* , const char* , int , LogLevelEnum , const char* , int , const char* , ...);
+
+/*
+* @brief      打印二进制日志(可变参数)
+* @note       由LOG_BIN宏在过滤通过后调用；只对写文件的日志生效：只拷贝参数，由守护进程格式化；
+*             需要打印命令行、格式串不支持或调用点登记失败时退回文本日志；
+*             udp不保证送达，只有LOG_TRANSPORT_UNIX和LOG_TRANSPORT_SHM使用二进制记录
+* @param[in]  site    调用点
+* @return     无
+*/
+void LogBinary(LogSite* , ...);
+
 /*
 * @brief      打印自定义字符数组
 * @note 
@@ -202,6 +311,49 @@ void Log(const char* , const char* , int , LogLevelEnum , const char* , int , co
 */
 void LogBuf(const char* , const char* , int , LogLevelEnum , const char* , int );                               
 
+/*
+* @brief      选择日志传输方式
+* @note       在LogInit前后、启动异步日志前调用；共享内存队列由守护进程创建，
+*             打开失败时返回失败且不改变当前方式，调用者可继续使用udp
+* @param[in]  transport   传输方式
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+int LogSetTransport(LogTransportEnum );
+
+/*
+* @brief      启动异步日志
+* @note       启动后Log()只把记录写入本线程的环形缓冲区，由后台线程发送；缓冲区满时丢弃并计数；
+*             fork出的子进程恢复同步发送，需要异步时在子进程中再次调用
+* @param[in]  ring_size   每线程缓冲区大小，取2的幂，<=0使用默认值
+* @return     执行结果
+* @retval     0       成功
+* @retval     其他    失败
+*/
+int LogAsyncStart(int );
+
+/*
+* @brief      停止异步日志
+* @note       发送完缓冲区中的记录后返回，之后Log()恢复同步发送
+* @return     无
+*/
+void LogAsyncStop(void);
+
+/*
+* @brief      异步日志丢弃条数
+* @note       线程缓冲区满时丢弃；线程数超过上限时该线程改为同步发送，不计入
+* @return     丢弃条数
+*/
+unsigned long LogAsyncDropped(void);
+
+/*
+* @brief      共享内存队列满丢弃条数
+* @note       同步发送时队列满不等待直接丢弃；后台线程最多等待LOG_SHM_WAIT_US后丢弃
+* @return     丢弃条数
+*/
+unsigned long LogShmDropped(void);
+
 
     /* ---- 函数声明结束 ---- */
 
@@ -210,4 +362,4 @@ void LogBuf(const char* , const char* , int , LogLevelEnum , const char* , int )
 }
 #endif
 
-#endif
\ No newline at end of file
+#endif
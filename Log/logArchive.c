@@ -0,0 +1,343 @@
+/*
+* @file      logArchive.c
+* @brief     日志归档源文件
+*
+* 后台线程从队列取滚动文件，压缩后按配置删除最旧的滚动文件
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include "logArchive.h"
+#include "logIndex.h"
+#include "../MessageQueue/queue.h"
+
+#if defined(__has_include)
+#if __has_include(<zlib.h>)
+#define LOG_HAVE_ZLIB           1
+#include <zlib.h>
+#endif
+#endif
+
+/*
+* @brief 滚动文件
+*/
+typedef struct LogArchiveFile{
+    char    name[NAME_MAX + 1];                         /* 文件名 */
+    time_t  mtime;                                      /* 最后写入时间 */
+    off_t   size;                                       /* 文件大小 */
+}LogArchiveFile;
+
+/*
+* @brief 归档线程状态
+*/
+typedef struct LogArchive{
+    LogArchiveConfig    cfg;                            /* 归档配置 */
+    char                folder[PATH_MAX];               /* 日志目录，以'/'结尾 */
+    char                prefix[NAME_MAX + 1];           /* 滚动文件名前缀，日志文件名加'.' */
+    AsyncQueueData*     queue;                          /* 待压缩的文件路径 */
+    pthread_t           thread;
+    int                 running;
+}LogArchiveData;
+
+static LogArchiveData log_archive;
+static char log_archive_stop;                           /* 地址作为停止标记放入队列 */
+
+/*
+* @brief      压缩一个滚动文件
+* @note       先写.gz.tmp，成功后改名并删除原文件；修改时间沿用原文件，按保留时间清理时以日志最后写入时间为准
+* @param[in]  path    滚动文件路径
+* @return     执行结果
+* @retval     0       成功或不压缩
+* @retval     -1      失败，原文件保留
+*/
+static int LogArchiveCompress(const char* path)
+{
+#ifdef LOG_HAVE_ZLIB
+    static char buf[LOG_ARCHIVE_BUF_SIZE];
+    char gz_path[PATH_MAX], tmp_path[PATH_MAX], mode[16];
+    struct timespec times[2];
+    struct stat st;
+    gzFile gz;
+    ssize_t n;
+    int fd;
+
+    if (log_archive.cfg.level <= 0) {
+        return 0;
+    }
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", path);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.gz.tmp", path);
+    snprintf(mode, sizeof(mode), "wb%d", log_archive.cfg.level);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((fstat(fd, &st) != 0) || ((gz = gzopen(tmp_path, mode)) == NULL)) {
+        close(fd);
+        return -1;
+    }
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        if (gzwrite(gz, buf, n) != n) {
+            n = -1;
+            break;
+        }
+    }
+    close(fd);
+    if ((gzclose(gz) != Z_OK) || (n < 0)) {
+        unlink(tmp_path);
+        return -1;
+    }
+
+    times[0] = st.st_atim;
+    times[1] = st.st_mtim;
+    utimensat(AT_FDCWD, tmp_path, times, 0);
+    if (rename(tmp_path, gz_path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    unlink(path);
+#else
+    (void)path;
+#endif
+    return 0;
+}
+
+/*
+* @brief      按滚动先后比较，旧版本的"log1"~"logN"在前
+*/
+static int LogArchiveCompare(const void* a, const void* b)
+{
+    return LogIndexRolledCompare(((const LogArchiveFile* )a)->name, ((const LogArchiveFile* )b)->name,
+                                 strlen(log_archive.prefix) - 1);
+}
+
+/*
+* @brief      清理滚动文件
+* @note       从最旧的开始删除，直到个数、总大小和保留时间都满足配置；旧版本的"log1"~"logN"一并计入，
+*             索引文件不单独计数，随滚动文件一起删除
+* @return     无
+*/
+static void LogArchiveRetain(void)
+{
+    const LogArchiveConfig* cfg = &(log_archive.cfg);
+    LogArchiveFile* files = NULL, *tmp;
+    char path[PATH_MAX + NAME_MAX + 1], idx_path[PATH_MAX + NAME_MAX + 1];
+    char base[NAME_MAX + 1];
+    size_t name_len;
+    int number = 0, capcity = 0, i;
+    off_t total = 0;
+    time_t now = time(NULL);
+    struct dirent* entry;
+    struct stat st;
+    DIR* dir;
+
+    if ((cfg->max_number <= 0) && (cfg->max_total <= 0) && (cfg->max_hours <= 0)) {
+        return;
+    }
+    dir = opendir(log_archive.folder);
+    if (dir == NULL) {
+        return;
+    }
+    snprintf(base, sizeof(base), "%.*s", (int)strlen(log_archive.prefix) - 1, log_archive.prefix);
+    while ((entry = readdir(dir)) != NULL) {
+        if (LogIndexRolled(entry->d_name, base) == 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s%s", log_archive.folder, entry->d_name);
+        if ((stat(path, &st) != 0) || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (number == capcity) {
+            capcity = (capcity == 0) ? 64 : capcity * 2;
+            tmp = (LogArchiveFile* )realloc(files, capcity * sizeof(LogArchiveFile));
+            if (tmp == NULL) {
+                break;
+            }
+            files = tmp;
+        }
+        strcpy(files[number].name, entry->d_name);
+        files[number].mtime = st.st_mtime;
+        files[number].size = st.st_size;
+        total += st.st_size;
+        number++;
+    }
+    closedir(dir);
+
+    qsort(files, number, sizeof(LogArchiveFile), LogArchiveCompare);
+    for (i = 0; i < number; i++) {
+        if (((cfg->max_number > 0) && (number - i > cfg->max_number)) ||
+            ((cfg->max_total > 0) && (total > cfg->max_total)) ||
+            ((cfg->max_hours > 0) && (now - files[i].mtime > (time_t)cfg->max_hours * 3600))) {
+            snprintf(path, sizeof(path), "%s%s", log_archive.folder, files[i].name);
+            unlink(path);
+            name_len = strlen(path);
+            if ((name_len > 3) && (strcmp(path + name_len - 3, ".gz") == 0)) {
+                path[name_len - 3] = '\0';
+            }
+            snprintf(idx_path, sizeof(idx_path), "%s%s", path, LOG_INDEX_SUFFIX);
+            unlink(idx_path);
+            total -= files[i].size;
+        }
+    }
+    free(files);
+}
+
+/*
+* @brief      归档线程
+* @note       取到滚动文件就压缩并清理，空闲时每LOG_ARCHIVE_CHECK_SEC秒按保留时间清理一次
+* @param[in]  arg     未使用
+* @return     NULL
+*/
+static void* LogArchiveThread(void* arg)
+{
+    struct timeval tv;
+    char* rolled;
+
+    (void)arg;
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), LOG_ARCHIVE_NICE);
+    LogArchiveRetain();
+    for (;;) {
+        tv.tv_sec = LOG_ARCHIVE_CHECK_SEC;
+        tv.tv_usec = 0;
+        rolled = (char* )AsyncQueuePopHead(log_archive.queue, &tv);
+        if (rolled == &log_archive_stop) {
+            break;
+        }
+        if (rolled != NULL) {
+            LogArchiveCompress(rolled);
+            free(rolled);
+        }
+        LogArchiveRetain();
+    }
+    return NULL;
+}
+
+/*
+* @brief      启动归档线程
+* @note       启动时先按配置清理一次已有的滚动文件
+* @param[in]  path    日志文件路径，滚动文件与它在同一目录
+* @param[in]  cfg     归档配置
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      失败
+*/
+int LogArchiveStart(const char* path, const LogArchiveConfig* cfg)
+{
+    const char* name = strrchr(path, '/');
+
+    name = (name == NULL) ? path : name + 1;
+    if ((name - path >= PATH_MAX) || (strlen(name) >= NAME_MAX)) {
+        return -1;
+    }
+    log_archive.cfg = *cfg;
+    if (log_archive.cfg.level > 9) {
+        log_archive.cfg.level = 9;
+    }
+    memcpy(log_archive.folder, path, name - path);
+    log_archive.folder[name - path] = '\0';
+    if (log_archive.folder[0] == '\0') {
+        strcpy(log_archive.folder, "./");
+    }
+    snprintf(log_archive.prefix, sizeof(log_archive.prefix), "%s.", name);
+
+    log_archive.queue = AsyncQueueDataCreate(LOG_ARCHIVE_QUEUE_SIZE);
+    if (log_archive.queue == NULL) {
+        return -1;
+    }
+    if (pthread_create(&(log_archive.thread), NULL, LogArchiveThread, NULL) != 0) {
+        AsyncQueueFree(log_archive.queue);
+        log_archive.queue = NULL;
+        return -1;
+    }
+    log_archive.running = 1;
+    return 0;
+}
+
+/*
+* @brief      生成滚动文件名
+* @note       取当前时间，与已有文件重名时毫秒数加一
+* @param[in]  path    日志文件路径
+* @param[out] out     滚动文件路径
+* @param[in]  size    缓存大小
+* @return     无
+*/
+void LogArchiveRollName(const char* path, char* out, int size)
+{
+    char gz_path[PATH_MAX];
+    struct timespec ts;
+    struct tm tm_now;
+    time_t local;
+    int ms;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    local = ts.tv_sec + log_archive.cfg.time_zone * 3600;
+    gmtime_r(&local, &tm_now);
+    for (ms = ts.tv_nsec / 1000000; ; ms++) {
+        snprintf(out, size, "%s.%04d%02d%02d-%02d%02d%02d-%03d", path,
+                 tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday,
+                 tm_now.tm_hour, tm_now.tm_min, tm_now.tm_sec, ms);
+        snprintf(gz_path, sizeof(gz_path), "%s.gz", out);
+        if ((access(out, F_OK) != 0) && (access(gz_path, F_OK) != 0)) {
+            break;
+        }
+    }
+}
+
+/*
+* @brief      提交滚动文件
+* @note       文件的写入必须已全部完成；由后台线程压缩和清理
+* @param[in]  rolled  滚动文件路径
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      失败，文件保持未压缩
+*/
+int LogArchivePush(const char* rolled)
+{
+    char* copy;
+
+    if (!log_archive.running) {
+        return -1;
+    }
+    copy = strdup(rolled);
+    if ((copy == NULL) || (AsyncQueuePushTail(log_archive.queue, copy) != 0)) {
+        free(copy);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* @brief      停止归档线程
+* @note       已提交的文件压缩完才返回
+* @return     无
+*/
+void LogArchiveStop(void)
+{
+    if (!log_archive.running) {
+        return;
+    }
+    AsyncQueuePushTail(log_archive.queue, &log_archive_stop);
+    pthread_join(log_archive.thread, NULL);
+    AsyncQueueFree(log_archive.queue);
+    log_archive.queue = NULL;
+    log_archive.running = 0;
+}
@@ -0,0 +1,93 @@
+/*
+* @file      logArchive.h
+* @brief     日志归档头文件
+*
+* 守护进程滚动出的日志文件交给后台线程压缩，并按个数、总大小和保留时间清理；
+* 滚动文件名为"log.YYYYmmdd-HHMMSS-mmm"，压缩后加".gz"，按文件名排序即按时间排序
+* gcc avic_log.c logBinary.c logUring.c logArchive.c logIndex.c ../MessageQueue/shmQueue.c ../MessageQueue/queue.c -lpthread -lz -o avic
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __LOG_ARCHIVE_H__INCLUDE_
+#define __LOG_ARCHIVE_H__INCLUDE_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <sys/types.h>
+
+    //---- 宏定义开始 ----//
+#define LOG_ARCHIVE_QUEUE_SIZE  1024            /* 等待压缩的文件个数上限，滚动时不会因此阻塞 */
+#define LOG_ARCHIVE_CHECK_SEC   60              /* 没有新文件时按保留时间清理的间隔 */
+#define LOG_ARCHIVE_NICE        10              /* 后台线程nice值，压缩不与接收争CPU */
+#define LOG_ARCHIVE_BUF_SIZE    (64 * 1024)     /* 压缩时每次读取长度 */
+    //---- 宏定义结束 ----//
+
+    /* ---- 结构体定义开始 ---- */
+/*
+* @brief 归档配置
+*/
+typedef struct LogArchiveConfig{
+    off_t   file_size;                                  /* 单个日志文件大小，超过后滚动 */
+    int     max_number;                                 /* 最多保留的滚动文件个数，0不限 */
+    off_t   max_total;                                  /* 滚动文件总大小上限，0不限 */
+    int     max_hours;                                  /* 滚动文件最长保留小时数，0不限 */
+    int     level;                                      /* gzip压缩级别1~9，0不压缩 */
+    int     time_zone;                                  /* 文件名中时间的时区 */
+}LogArchiveConfig;
+    /* ---- 结构体定义结束 ---- */
+
+    /* ---- 函数声明开始 ---- */
+/*
+* @brief      启动归档线程
+* @note       启动时先按配置清理一次已有的滚动文件
+* @param[in]  path    日志文件路径，滚动文件与它在同一目录
+* @param[in]  cfg     归档配置
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      失败
+*/
+int LogArchiveStart(const char* , const LogArchiveConfig* );
+
+/*
+* @brief      生成滚动文件名
+* @note       取当前时间，与已有文件重名时毫秒数加一
+* @param[in]  path    日志文件路径
+* @param[out] out     滚动文件路径
+* @param[in]  size    缓存大小
+* @return     无
+*/
+void LogArchiveRollName(const char* , char* , int );
+
+/*
+* @brief      提交滚动文件
+* @note       文件的写入必须已全部完成；由后台线程压缩和清理
+* @param[in]  rolled  滚动文件路径
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      失败，文件保持未压缩
+*/
+int LogArchivePush(const char* );
+
+/*
+* @brief      停止归档线程
+* @note       已提交的文件压缩完才返回
+* @return     无
+*/
+void LogArchiveStop(void);
+    /* ---- 函数声明结束 ---- */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,737 @@
+/*
+* @file      logBinary.c
+* @brief     二进制日志源文件
+*
+* 格式串解析、参数编码和守护进程端解码
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include "logBinary.h"
+
+#define LOG_BIN_MAX_SPEC        32              /* 单个转换说明最大长度 */
+#define LOG_BIN_MAX_STRING      4096            /* 解码时字符串参数最大长度 */
+
+static const char log_bin_level_char[] = {'V', 'D', 'I', 'W', 'E', 'A'};
+
+/*
+* @brief      跳过一个转换说明的标志、宽度、精度和长度修饰
+* @note       p指向'%'之后；宽度或精度为'*'时记一个int参数
+* @param[in]  p       格式串位置
+* @param[out] stars   '*'个数
+* @param[out] limit   精度，无精度为LOG_BIN_NO_LIMIT
+* @param[out] length  长度修饰：0无、'h'、'l'、'L'(long long)、'z'、'j'、'D'(long double)
+* @return     转换字符位置
+*/
+static const char*
+LogBinarySpec(const char* p, int* stars, int* limit, int* length)
+{
+    *stars = 0;
+    *limit = LOG_BIN_NO_LIMIT;
+    *length = 0;
+
+    while ((*p != '\0') && (strchr("-+ #0'", *p) != NULL)) {
+        p++;
+    }
+    if (*p == '*') {
+        (*stars)++;
+        p++;
+    } else {
+        while ((*p >= '0') && (*p <= '9')) {
+            p++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            (*stars)++;
+            *limit = LOG_BIN_STAR_LIMIT;
+            p++;
+        } else {
+            *limit = 0;
+            while ((*p >= '0') && (*p <= '9')) {
+                *limit = *limit * 10 + (*p++ - '0');
+            }
+            if (*limit >= LOG_BIN_STAR_LIMIT) {
+                *limit = LOG_BIN_STAR_LIMIT - 1;
+            }
+        }
+    }
+    for (;;) {
+        switch (*p) {
+        case 'h':
+            *length = 'h';
+            break;
+        case 'l':
+            *length = (*length == 'l') ? 'L' : 'l';
+            break;
+        case 'q':
+            *length = 'L';
+            break;
+        case 'j':
+            *length = 'j';
+            break;
+        case 'z':
+        case 't':
+            *length = 'z';
+            break;
+        case 'L':
+            *length = 'D';
+            break;
+        default:
+            return p;
+        }
+        p++;
+    }
+}
+
+/*
+* @brief      解析调用点格式串
+* @note       记录每个参数的类型；%n或参数过多时arg_number置-1
+* @param[in]  site    调用点
+* @return     参数个数，-1表示不支持
+*/
+int
+LogBinaryParse(LogSite* site)
+{
+    const char* p = site->format, *start;
+    int n = 0, stars, limit, length, type;
+
+    while (*p != '\0') {
+        if (*p++ != '%') {
+            continue;
+        }
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+        start = p - 1;
+        p = LogBinarySpec(p, &stars, &limit, &length);
+        /* 守护进程把转换说明复制到定长缓存，过长(如重复的长度修饰)不支持 */
+        if ((n + stars >= LOG_BIN_MAX_ARGS) || (p - start > LOG_BIN_MAX_SPEC - 4)) {
+            goto unsupported;
+        }
+        while (stars-- > 0) {
+            site->arg_types[n] = LOG_ARG_INT;
+            site->arg_limits[n++] = LOG_BIN_NO_LIMIT;
+        }
+
+        switch (*p) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            type = (length == 'l') ? LOG_ARG_LONG :
+                   ((length == 'L') || (length == 'j')) ? LOG_ARG_LLONG :
+                   (length == 'z') ? LOG_ARG_SIZE : LOG_ARG_INT;
+            break;
+        case 'c':
+            type = LOG_ARG_INT;
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            if (length == 'D') {
+                goto unsupported;
+            }
+            type = LOG_ARG_DOUBLE;
+            break;
+        case 's':
+            if (length == 'l') {
+                goto unsupported;
+            }
+            type = LOG_ARG_STRING;
+            break;
+        case 'p':
+            type = LOG_ARG_POINTER;
+            break;
+        default:
+            goto unsupported;
+        }
+        site->arg_types[n] = type;
+        site->arg_limits[n++] = limit;
+        p++;
+    }
+    site->arg_number = n;
+    return n;
+
+unsupported:
+    site->arg_number = -1;
+    return -1;
+}
+
+/*
+* @brief      编码调用点登记记录
+* @note
+* @param[out] out     输出缓存
+* @param[in]  size    缓存大小
+* @param[in]  site    调用点
+* @param[in]  pid     进程ID
+* @return     记录长度，缓存不足返回-1
+*/
+int
+LogBinaryEncodeSite(char* out, int size, const LogSite* site, int pid)
+{
+    const char* strings[4] = {site->file, site->func, site->log_id, site->format};
+    LogBinHead head;
+    int32_t line = site->line;
+    int len = sizeof(head) + sizeof(line), i, n;
+
+    for (i = 0; i < 4; i++) {
+        n = strlen(strings[i]) + 1;
+        if (len + n > size || len + n > 0xFFFF) {
+            return -1;
+        }
+        memcpy(out + len, strings[i], n);
+        len += n;
+    }
+
+    head.magic = LOG_BIN_SITE;
+    head.level = site->level;
+    head.len = len;
+    head.site = site->id;
+    head.pid = pid;
+    head.tid = 0;
+    head.time = 0;
+    memcpy(out, &head, sizeof(head));
+    memcpy(out + sizeof(head), &line, sizeof(line));
+    return len;
+}
+
+/*
+* @brief      编码参数记录
+* @note       只拷贝参数原始值，字符串拷贝内容；字符串放不下时截断
+* @param[out] out     输出缓存
+* @param[in]  size    缓存大小
+* @param[in]  site    已登记的调用点
+* @param[in]  pid     进程ID
+* @param[in]  tid     线程ID
+* @param[in]  vp      可变参数
+* @return     记录长度，缓存不足返回-1
+*/
+int
+LogBinaryEncode(char* out, int size, const LogSite* site, int pid, long tid, va_list vp)
+{
+    LogBinHead head;
+    uint64_t event_time = LogBinaryTime();
+    int len = sizeof(head), i, last_int = 0;
+    int32_t v32;
+    int64_t v64;
+    double vd;
+    const char* str;
+    size_t str_len;
+    uint16_t n16;
+
+    if (size > 0xFFFF) {
+        size = 0xFFFF;
+    }
+    for (i = 0; i < site->arg_number; i++) {
+        switch (site->arg_types[i]) {
+        case LOG_ARG_INT:
+            if (len + (int)sizeof(v32) > size) {
+                return -1;
+            }
+            v32 = last_int = va_arg(vp, int);
+            memcpy(out + len, &v32, sizeof(v32));
+            len += sizeof(v32);
+            continue;
+        case LOG_ARG_LONG:
+            v64 = va_arg(vp, long);
+            break;
+        case LOG_ARG_LLONG:
+            v64 = va_arg(vp, long long);
+            break;
+        case LOG_ARG_SIZE:
+            v64 = (int64_t)va_arg(vp, size_t);
+            break;
+        case LOG_ARG_POINTER:
+            v64 = (int64_t)(uintptr_t)va_arg(vp, void* );
+            break;
+        case LOG_ARG_DOUBLE:
+            vd = va_arg(vp, double);
+            memcpy(&v64, &vd, sizeof(v64));
+            break;
+        default:
+            str = va_arg(vp, const char* );
+            if (str == NULL) {
+                str = "(null)";
+            }
+            /* 有精度时最多读精度个字节，字符串可以不以'\0'结尾 */
+            if (site->arg_limits[i] == LOG_BIN_STAR_LIMIT) {
+                str_len = (last_int < 0) ? strlen(str) : strnlen(str, last_int);
+            } else if (site->arg_limits[i] != LOG_BIN_NO_LIMIT) {
+                str_len = strnlen(str, site->arg_limits[i]);
+            } else {
+                str_len = strlen(str);
+            }
+            if (len + (int)sizeof(n16) > size) {
+                return -1;
+            }
+            if (str_len > (size_t)(size - len - sizeof(n16))) {
+                str_len = size - len - sizeof(n16);
+            }
+            n16 = str_len;
+            memcpy(out + len, &n16, sizeof(n16));
+            memcpy(out + len + sizeof(n16), str, str_len);
+            len += sizeof(n16) + str_len;
+            continue;
+        }
+        if (len + (int)sizeof(v64) > size) {
+            return -1;
+        }
+        memcpy(out + len, &v64, sizeof(v64));
+        len += sizeof(v64);
+    }
+
+    head.magic = LOG_BIN_DATA;
+    head.level = site->level;
+    head.len = len;
+    head.site = site->id;
+    head.pid = pid;
+    head.tid = tid;
+    head.time = event_time;
+    memcpy(out, &head, sizeof(head));
+    return len;
+}
+
+/*
+* @brief      调用点在表中的起始位置
+* @note
+* @param[in]  pid     进程ID
+* @param[in]  site    调用点编号
+* @return     下标
+*/
+static uint32_t
+LogSiteTableHash(int32_t pid, uint32_t site)
+{
+    return (((uint32_t)pid * 2654435761u) ^ (site * 40503u)) % LOG_BIN_MAX_SITES;
+}
+
+/*
+* @brief      调用点表查找
+* @note       线性探测
+* @param[in]  table   调用点表
+* @param[in]  pid     进程ID
+* @param[in]  site    调用点编号
+* @param[in]  insert  找不到时是否返回空位
+* @return     表项，找不到返回NULL
+*/
+static LogSiteEntry*
+LogSiteTableFind(LogSiteTable* table, int32_t pid, uint32_t site, int insert)
+{
+    uint32_t hash = LogSiteTableHash(pid, site), i;
+    LogSiteEntry* entry;
+
+    for (i = 0; i < LOG_BIN_MAX_SITES; i++) {
+        entry = &(table->entries[(hash + i) % LOG_BIN_MAX_SITES]);
+        if (entry->pid == 0) {
+            return insert ? entry : NULL;
+        }
+        if ((entry->pid == pid) && (entry->site.id == site)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/*
+* @brief      删除调用点表项
+* @note       线性探测不能直接留空位，把后面探测链上的表项依次前移填补
+* @param[in]  table   调用点表
+* @param[in]  index   表项下标
+* @return     无
+*/
+static void
+LogSiteTableRemove(LogSiteTable* table, uint32_t index)
+{
+    uint32_t next = index, home;
+
+    free(table->entries[index].strings);
+    table->number--;
+    for (;;) {
+        next = (next + 1) % LOG_BIN_MAX_SITES;
+        if (table->entries[next].pid == 0) {
+            break;
+        }
+        home = LogSiteTableHash(table->entries[next].pid, table->entries[next].site.id);
+        /* 起始位置在(index, next]之间的表项不经过空位，留在原处 */
+        if ((index <= next) ? ((index < home) && (home <= next)) : ((index < home) || (home <= next))) {
+            continue;
+        }
+        table->entries[index] = table->entries[next];
+        index = next;
+    }
+    memset(&(table->entries[index]), 0, sizeof(table->entries[index]));
+}
+
+/*
+* @brief      清除已退出进程的调用点
+* @note       表满时调用；kill(pid, 0)返回ESRCH视为进程已退出，同一秒内清理无果不再重复
+* @param[in]  table   调用点表
+* @return     无
+*/
+static void
+LogSiteTableSweep(LogSiteTable* table)
+{
+    int64_t now = time(NULL);
+    int32_t pid = 0, dead = 0;
+    int number = table->number;
+    uint32_t i = 0;
+
+    if (table->sweep_time == now) {
+        return;
+    }
+    while (i < LOG_BIN_MAX_SITES) {
+        if (table->entries[i].pid == 0) {
+            i++;
+            continue;
+        }
+        if (table->entries[i].pid != pid) {
+            pid = table->entries[i].pid;
+            dead = (kill(pid, 0) != 0) && (errno == ESRCH);
+        }
+        /* 删除后后面的表项可能前移到当前位置，重新检查 */
+        if (dead) {
+            LogSiteTableRemove(table, i);
+        } else {
+            i++;
+        }
+    }
+    table->sweep_time = (table->number < number) ? 0 : now;
+}
+
+/*
+* @brief      登记调用点
+* @note       同一进程ID再次登记时覆盖，进程ID复用后编号从头开始
+* @param[in]  table   调用点表
+* @param[in]  head    记录头
+* @param[in]  in      记录
+* @return     无
+*/
+static void
+LogSiteTableAdd(LogSiteTable* table, const LogBinHead* head, const char* in)
+{
+    LogSiteEntry* entry;
+    const char* p;
+    int32_t line;
+    int n = head->len - sizeof(*head) - sizeof(line), i;
+    char* strings;
+
+    if ((n <= 0) || (in[head->len - 1] != '\0')) {
+        return;
+    }
+    entry = LogSiteTableFind(table, head->pid, head->site, 1);
+    if ((entry != NULL) && (entry->pid == 0) && (table->number >= LOG_BIN_MAX_SITES - 1)) {
+        LogSiteTableSweep(table);
+        entry = LogSiteTableFind(table, head->pid, head->site, 1);
+    }
+    if ((entry == NULL) || ((entry->pid == 0) && (table->number >= LOG_BIN_MAX_SITES - 1))) {
+        return;
+    }
+    strings = (char* )malloc(n);
+    if (strings == NULL) {
+        return;
+    }
+    memcpy(&line, in + sizeof(*head), sizeof(line));
+    memcpy(strings, in + sizeof(*head) + sizeof(line), n);
+
+    if (entry->pid == 0) {
+        table->number++;
+    } else {
+        free(entry->strings);
+    }
+    entry->pid = head->pid;
+    entry->strings = strings;
+    memset(&(entry->site), 0, sizeof(entry->site));
+    entry->site.id = head->site;
+    entry->site.level = head->level;
+    entry->site.line = line;
+
+    /* 依次取出四个字符串，个数不足视为损坏 */
+    p = strings;
+    for (i = 0; i < 4; i++) {
+        if (p >= strings + n) {
+            p = "";
+        }
+        switch (i) {
+        case 0: entry->site.file = p; break;
+        case 1: entry->site.func = p; break;
+        case 2: entry->site.log_id = p; break;
+        default: entry->site.format = p; break;
+        }
+        p += strlen(p) + 1;
+    }
+    LogBinaryParse(&(entry->site));
+}
+
+/* 按'*'个数调用snprintf */
+#define LOG_BIN_PRINT(out, size, spec, stars, star, value)                                  \
+    (((stars) == 0) ? snprintf(out, size, spec, value) :                                    \
+     ((stars) == 1) ? snprintf(out, size, spec, star[0], value) :                           \
+                      snprintf(out, size, spec, star[0], star[1], value))
+
+/*
+* @brief      按格式串格式化参数
+* @note       逐个转换说明调用snprintf；64位整数统一改用ll修饰
+* @param[in]  site    调用点
+* @param[in]  in      参数数据
+* @param[in]  in_len  参数数据长度
+* @param[out] out     输出缓存
+* @param[in]  size    缓存大小
+* @return     输出长度，参数数据损坏返回-1
+*/
+static int
+LogBinaryFormat(const LogSite* site, const char* in, int in_len, char* out, int size)
+{
+    const char *p = site->format, *start, *conv;
+    char spec[LOG_BIN_MAX_SPEC], str[LOG_BIN_MAX_STRING];
+    int len = 0, pos = 0, arg = 0, stars, limit, length, star[2], n, spec_len;
+    int32_t v32;
+    int64_t v64;
+    double vd;
+    uint16_t n16;
+
+    while ((*p != '\0') && (len < size - 1)) {
+        if ((*p != '%') || (p[1] == '%')) {
+            out[len++] = *p;
+            p += (*p == '%') ? 2 : 1;
+            continue;
+        }
+        start = p++;
+        conv = LogBinarySpec(p, &stars, &limit, &length);
+        p = conv + 1;
+
+        for (n = 0; n < stars; n++) {
+            if ((arg >= site->arg_number) || (pos + (int)sizeof(v32) > in_len)) {
+                return -1;
+            }
+            memcpy(&v32, in + pos, sizeof(v32));
+            star[n] = v32;
+            pos += sizeof(v32);
+            arg++;
+        }
+        if (arg >= site->arg_number) {
+            return -1;
+        }
+
+        /* 复制到长度修饰之前，再按参数宽度补修饰；格式串来自客户端，按未去修饰的长度检查 */
+        spec_len = conv - start;
+        if (spec_len > LOG_BIN_MAX_SPEC - 4) {
+            return -1;
+        }
+        while ((spec_len > 1) && (strchr("hlqjztL", start[spec_len - 1]) != NULL)) {
+            spec_len--;
+        }
+        memcpy(spec, start, spec_len);
+
+        switch (site->arg_types[arg]) {
+        case LOG_ARG_INT:
+            if (pos + (int)sizeof(v32) > in_len) {
+                return -1;
+            }
+            memcpy(&v32, in + pos, sizeof(v32));
+            pos += sizeof(v32);
+            /* int类参数保留原修饰，如%hhx、%lc */
+            spec_len = conv - start;
+            memcpy(spec, start, spec_len);
+            spec[spec_len] = *conv;
+            spec[spec_len + 1] = '\0';
+            n = LOG_BIN_PRINT(out + len, size - len, spec, stars, star, (int)v32);
+            break;
+        case LOG_ARG_DOUBLE:
+            if (pos + (int)sizeof(vd) > in_len) {
+                return -1;
+            }
+            memcpy(&vd, in + pos, sizeof(vd));
+            pos += sizeof(vd);
+            spec[spec_len] = *conv;
+            spec[spec_len + 1] = '\0';
+            n = LOG_BIN_PRINT(out + len, size - len, spec, stars, star, vd);
+            break;
+        case LOG_ARG_STRING:
+            if (pos + (int)sizeof(n16) > in_len) {
+                return -1;
+            }
+            memcpy(&n16, in + pos, sizeof(n16));
+            pos += sizeof(n16);
+            if (pos + n16 > in_len) {
+                return -1;
+            }
+            n = (n16 < sizeof(str)) ? n16 : (int)sizeof(str) - 1;
+            memcpy(str, in + pos, n);
+            str[n] = '\0';
+            pos += n16;
+            spec[spec_len] = 's';
+            spec[spec_len + 1] = '\0';
+            n = LOG_BIN_PRINT(out + len, size - len, spec, stars, star, str);
+            break;
+        case LOG_ARG_POINTER:
+            if (pos + (int)sizeof(v64) > in_len) {
+                return -1;
+            }
+            memcpy(&v64, in + pos, sizeof(v64));
+            pos += sizeof(v64);
+            spec[spec_len] = 'p';
+            spec[spec_len + 1] = '\0';
+            n = LOG_BIN_PRINT(out + len, size - len, spec, stars, star, (void* )(uintptr_t)v64);
+            break;
+        default:
+            if (pos + (int)sizeof(v64) > in_len) {
+                return -1;
+            }
+            memcpy(&v64, in + pos, sizeof(v64));
+            pos += sizeof(v64);
+            memcpy(spec + spec_len, "ll", 2);
+            spec[spec_len + 2] = *conv;
+            spec[spec_len + 3] = '\0';
+            n = LOG_BIN_PRINT(out + len, size - len, spec, stars, star, (long long)v64);
+            break;
+        }
+        arg++;
+        if (n < 0) {
+            return -1;
+        }
+        len += n;
+        if (len >= size) {
+            len = size - 1;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+/*
+* @brief      填写文本记录头
+* @note       文本由调用者写在记录头之后
+* @param[out] out      记录
+* @param[in]  level    日志级别
+* @param[in]  pid      进程ID
+* @param[in]  tid      线程ID
+* @param[in]  event_time 事件时间，见LogBinaryTime
+* @param[in]  text_len 文本长度，含结尾'\0'
+* @return     记录长度
+*/
+int
+LogBinaryEncodeText(char* out, int level, int pid, long tid, uint64_t event_time, int text_len)
+{
+    LogBinHead head;
+
+    head.magic = LOG_BIN_TEXT;
+    head.level = level;
+    head.len = sizeof(head) + text_len;
+    head.site = 0;
+    head.pid = pid;
+    head.tid = tid;
+    head.time = event_time;
+    memcpy(out, &head, sizeof(head));
+    return head.len;
+}
+
+/*
+* @brief      取事件时间
+* @note       使用LOG_CLOCK，vDSO实现不进入内核
+* @return     自1970年起的微秒数
+*/
+uint64_t
+LogBinaryTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(LOG_CLOCK, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+* @brief      解码一条记录
+* @note       登记记录存入调用点表，不产生文本；参数记录格式化成与文本日志相同的格式，文本记录原样拷贝
+* @param[in]  table   调用点表
+* @param[in]  in      记录
+* @param[in]  in_len  剩余数据长度
+* @param[out] used    本条记录长度
+* @param[out] event_time 事件时间
+* @param[out] out     文本输出缓存
+* @param[in]  out_size 缓存大小
+* @return     文本长度，登记记录返回0
+* @retval     -1      记录不完整或损坏
+*/
+int
+LogBinaryDecode(LogSiteTable* table, const char* in, int in_len, int* used, uint64_t* event_time, char* out, int out_size)
+{
+    LogBinHead head;
+    LogSiteEntry* entry;
+    char level;
+    int len, n;
+
+    if ((in_len < (int)sizeof(head)) || (out_size <= 0)) {
+        return -1;
+    }
+    memcpy(&head, in, sizeof(head));
+    if ((head.len < sizeof(head)) || (head.len > in_len)) {
+        return -1;
+    }
+    *used = head.len;
+    *event_time = head.time;
+
+    if (head.magic == LOG_BIN_SITE) {
+        LogSiteTableAdd(table, &head, in);
+        return 0;
+    }
+    if (head.magic == LOG_BIN_TEXT) {
+        len = strnlen(in + sizeof(head), head.len - sizeof(head));
+        if (len >= out_size) {
+            len = out_size - 1;
+        }
+        memcpy(out, in + sizeof(head), len);
+        return len;
+    }
+    if (head.magic != LOG_BIN_DATA) {
+        return -1;
+    }
+
+    level = (head.level < sizeof(log_bin_level_char)) ? log_bin_level_char[head.level] : '?';
+    entry = LogSiteTableFind(table, head.pid, head.site, 0);
+    if ((entry == NULL) || (entry->site.arg_number < 0)) {
+        return snprintf(out, out_size, "[%c][PID:%d TID:%d]unknown log site %u",
+                        level, head.pid, head.tid, head.site);
+    }
+
+    len = snprintf(out, out_size, "[%c][PID:%d TID:%d][%s %s][LINE:%d]%s->:",
+                   level, head.pid, head.tid, entry->site.file, entry->site.func,
+                   entry->site.line, entry->site.log_id);
+    if (len >= out_size) {
+        return out_size - 1;
+    }
+    n = LogBinaryFormat(&(entry->site), in + sizeof(head), head.len - sizeof(head), out + len, out_size - len);
+    if (n < 0) {
+        return snprintf(out + len, out_size - len, "bad log record") + len;
+    }
+    return len + n;
+}
+
+/*
+* @brief      释放调用点表中的字符串
+* @note
+* @param[in]  table   调用点表
+* @return     无
+*/
+void
+LogSiteTableClear(LogSiteTable* table)
+{
+    int i;
+
+    for (i = 0; i < LOG_BIN_MAX_SITES; i++) {
+        if (table->entries[i].pid != 0) {
+            free(table->entries[i].strings);
+        }
+    }
+    memset(table, 0, sizeof(*table));
+}
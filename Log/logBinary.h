@@ -0,0 +1,193 @@
+/*
+* @file      logBinary.h
+* @brief     二进制日志头文件
+*
+* 调用点描述(文件、函数、行号、格式串)每个进程只登记一次，之后每条日志只传原始参数，
+* 由守护进程按格式串格式化；客户端与守护进程共用本文件
+* gcc app.c log.c logBinary.c ../MessageQueue/shmQueue.c -lpthread
+* gcc avic_log.c logBinary.c logUring.c logArchive.c logIndex.c ../MessageQueue/shmQueue.c ../MessageQueue/queue.c -lpthread -lz -o avic
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __LOG_BINARY_H__INCLUDE_
+#define __LOG_BINARY_H__INCLUDE_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdarg.h>
+
+    //---- 宏定义开始 ----//
+#define LOG_BIN_SITE            0x01            /* 调用点登记记录 */
+#define LOG_BIN_DATA            0x02            /* 参数记录 */
+#define LOG_BIN_TEXT            0x03            /* 文本记录，记录头后为以'\0'结尾的文本 */
+#define LOG_BIN_MAX_ARGS        16              /* 单条日志最多参数个数 */
+#define LOG_BIN_MAX_SITES       4096            /* 守护进程最多登记的调用点 */
+
+/* 客户端取事件时间的时钟，只需毫秒级精度时可定义为CLOCK_REALTIME_COARSE */
+#ifndef LOG_CLOCK
+#define LOG_CLOCK               CLOCK_REALTIME
+#endif
+
+#define LOG_BIN_NO_LIMIT        0xFFFF          /* 字符串无精度限制 */
+#define LOG_BIN_STAR_LIMIT      0xFFFE          /* 字符串精度由前一个int参数给出 */
+
+/* 参数类型，整数和指针编码时统一为8字节，int为4字节 */
+#define LOG_ARG_INT             1               /* int及更短的整数 */
+#define LOG_ARG_LONG            2               /* long */
+#define LOG_ARG_LLONG           3               /* long long、intmax_t */
+#define LOG_ARG_SIZE            4               /* size_t、ptrdiff_t */
+#define LOG_ARG_POINTER         5               /* 指针 */
+#define LOG_ARG_DOUBLE          6               /* 浮点 */
+#define LOG_ARG_STRING          7               /* 字符串，2字节长度加内容 */
+    //---- 宏定义结束 ----//
+
+    /* ---- 结构体定义开始 ---- */
+/*
+* @brief 调用点描述
+* @note  由LOG_BIN宏在调用点静态定义，首次调用时解析格式串并分配编号
+*/
+typedef struct LogSite{
+    const char*  file;                                  /* 代码文件名 */
+    const char*  func;                                  /* 函数名 */
+    int          line;                                  /* 代码行数 */
+    int          level;                                 /* 日志级别 */
+    const char*  log_id;                                /* 模块ID */
+    int          flag;                                  /* 打印标识 */
+    const char*  format;                                /* 格式串 */
+    uint32_t     id;                                    /* 进程内编号，0表示未登记 */
+    int          arg_number;                            /* 参数个数，-1表示格式串不支持 */
+    uint8_t      arg_types[LOG_BIN_MAX_ARGS];           /* 参数类型 */
+    uint16_t     arg_limits[LOG_BIN_MAX_ARGS];          /* 字符串精度，防止读越界 */
+    uint32_t     cache;                                 /* 过滤结果缓存，见LogCacheEnabled */
+    uint32_t     epoch;                                 /* 登记时的版本，fork后与进程版本不同，重新登记 */
+    uint32_t     registered;                            /* 上次发送登记的单调时间，秒 */
+}LogSite;
+
+/*
+* @brief 记录头
+* @note  一个数据报可以依次放多条记录，按len前进；time在客户端写日志时取得，
+*        守护进程按它打时间戳，批量发送不影响日志时间
+*/
+typedef struct LogBinHead{
+    uint8_t   magic;                                    /* LOG_BIN_SITE或LOG_BIN_DATA */
+    uint8_t   level;                                    /* 日志级别 */
+    uint16_t  len;                                      /* 整条记录长度，含记录头 */
+    uint32_t  site;                                     /* 调用点编号 */
+    int32_t   pid;                                      /* 进程ID */
+    int32_t   tid;                                      /* 线程ID */
+    uint64_t  time;                                     /* 事件时间，自1970年起的微秒数 */
+}LogBinHead;
+
+/*
+* @brief 守护进程中登记的调用点
+*/
+typedef struct LogSiteEntry{
+    int32_t   pid;                                      /* 进程ID，0表示空位 */
+    LogSite   site;                                     /* 调用点，字符串指向strings，参数类型由守护进程重新解析 */
+    char*     strings;                                  /* 文件名、函数名、模块ID、格式串，依次以'\0'分隔 */
+}LogSiteEntry;
+
+/*
+* @brief 守护进程调用点表
+* @note  以(pid, site)为键的开放寻址哈希表，表满时清除已退出进程的调用点
+*/
+typedef struct LogSiteTable{
+    LogSiteEntry  entries[LOG_BIN_MAX_SITES];
+    int           number;                               /* 已登记个数 */
+    int64_t       sweep_time;                           /* 上次清理未腾出空位的时间，秒，同一秒内不再清理 */
+}LogSiteTable;
+    /* ---- 结构体定义结束 ---- */
+
+    /* ---- 函数声明开始 ---- */
+/*
+* @brief      解析调用点格式串
+* @note       记录每个参数的类型；%n或参数过多时arg_number置-1
+* @param[in]  site    调用点
+* @return     参数个数，-1表示不支持
+*/
+int LogBinaryParse(LogSite* );
+
+/*
+* @brief      编码调用点登记记录
+* @note
+* @param[out] out     输出缓存
+* @param[in]  size    缓存大小
+* @param[in]  site    调用点
+* @param[in]  pid     进程ID
+* @return     记录长度，缓存不足返回-1
+*/
+int LogBinaryEncodeSite(char* , int , const LogSite* , int );
+
+/*
+* @brief      编码参数记录
+* @note       只拷贝参数原始值，字符串拷贝内容
+* @param[out] out     输出缓存
+* @param[in]  size    缓存大小
+* @param[in]  site    已登记的调用点
+* @param[in]  pid     进程ID
+* @param[in]  tid     线程ID
+* @param[in]  vp      可变参数
+* @return     记录长度，缓存不足返回-1
+*/
+int LogBinaryEncode(char* , int , const LogSite* , int , long , va_list );
+
+/*
+* @brief      填写文本记录头
+* @note       文本由调用者写在记录头之后
+* @param[out] out      记录
+* @param[in]  level    日志级别
+* @param[in]  pid      进程ID
+* @param[in]  tid      线程ID
+* @param[in]  event_time 事件时间，见LogBinaryTime
+* @param[in]  text_len 文本长度，含结尾'\0'
+* @return     记录长度
+*/
+int LogBinaryEncodeText(char* , int , int , long , uint64_t , int );
+
+/*
+* @brief      取事件时间
+* @note       使用LOG_CLOCK，vDSO实现不进入内核
+* @return     自1970年起的微秒数
+*/
+uint64_t LogBinaryTime(void);
+
+/*
+* @brief      解码一条记录
+* @note       登记记录存入调用点表，不产生文本；参数记录格式化成与文本日志相同的格式，文本记录原样拷贝
+* @param[in]  table   调用点表
+* @param[in]  in      记录
+* @param[in]  in_len  剩余数据长度
+* @param[out] used    本条记录长度
+* @param[out] event_time 事件时间
+* @param[out] out     文本输出缓存
+* @param[in]  out_size 缓存大小
+* @return     文本长度，登记记录返回0
+* @retval     -1      记录不完整或损坏
+*/
+int LogBinaryDecode(LogSiteTable* , const char* , int , int* , uint64_t* , char* , int );
+
+/*
+* @brief      释放调用点表中的字符串
+* @note
+* @param[in]  table   调用点表
+* @return     无
+*/
+void LogSiteTableClear(LogSiteTable* );
+    /* ---- 函数声明结束 ---- */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+/*
+* @file      logBinaryCheck.c
+* @brief     二进制日志解码检查
+*
+* 构造调用点登记和参数记录交给守护进程的解码函数，检查格式化结果和异常格式串；
+* gcc -fsanitize=address logBinaryCheck.c logBinary.c -o logBinaryCheck
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "logBinary.h"
+
+#define CHECK_PID       1234
+
+static LogSiteTable check_table;
+
+/*
+* @brief      编码参数记录
+* @note
+* @param[out] out     输出缓存
+* @param[in]  size    缓存大小
+* @param[in]  site    调用点
+* @return     记录长度
+*/
+static int
+CheckEncode(char* out, int size, const LogSite* site, ...)
+{
+    va_list vp;
+    int len;
+
+    va_start(vp, site);
+    len = LogBinaryEncode(out, size, site, CHECK_PID, CHECK_PID, vp);
+    va_end(vp);
+    return len;
+}
+
+/*
+* @brief      登记调用点并解码一条记录
+* @note       调用点不经客户端解析，参数类型直接指定，模拟恶意客户端
+* @param[in]  format  格式串
+* @param[in]  id      调用点编号
+* @param[in]  expect  期望文本结尾，NULL表示只要求不越界
+* @return     0成功，-1失败
+*/
+static int
+CheckDecode(const char* format, uint32_t id, const char* expect)
+{
+    LogSite site = {"check.c", "main", 1, 2, "CHECK", 0, format, id, 1, {LOG_ARG_INT}, {LOG_BIN_NO_LIMIT}, 0};
+    char in[4096], out[4096];
+    uint64_t time;
+    int len, used, n;
+
+    len = LogBinaryEncodeSite(in, sizeof(in), &site, CHECK_PID);
+    if ((len < 0) || (LogBinaryDecode(&check_table, in, len, &used, &time, out, sizeof(out)) != 0)) {
+        printf("site %u: encode site failed\n", id);
+        return -1;
+    }
+    len = CheckEncode(in, sizeof(in), &site, 0x1ff);
+    n = LogBinaryDecode(&check_table, in, len, &used, &time, out, sizeof(out));
+    if (n < 0) {
+        printf("site %u: decode failed\n", id);
+        return -1;
+    }
+    out[n] = '\0';
+    if ((expect != NULL) && ((n < (int)strlen(expect)) || (strcmp(out + n - strlen(expect), expect) != 0))) {
+        printf("site %u: \"%s\" not end with \"%s\"\n", id, out, expect);
+        return -1;
+    }
+    printf("site %u: %s\n", id, out);
+    return 0;
+}
+
+int
+main(void)
+{
+    char format[128];
+    int ret = 0;
+
+    ret |= CheckDecode("value %hhx", 1, "value ff");
+    ret |= CheckDecode("value %5d", 2, "value   511");
+
+    /* 重复的长度修饰使转换说明超过解码缓存，不能按原样复制 */
+    snprintf(format, sizeof(format), "%%5%.60sd", "hhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhh");
+    ret |= CheckDecode(format, 3, NULL);
+
+    LogSiteTableClear(&check_table);
+    printf("%s\n", ret == 0 ? "pass" : "fail");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,283 @@
+/*
+* @file      logIndex.c
+* @brief     日志段索引源文件
+*
+* 日志行解析、块统计和时间字符串解析
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include "logIndex.h"
+
+/*
+* @brief      级别字符转级别
+* @note
+* @param[in]  c       日志文本中的级别字符
+* @return     0~5对应VERBOSE~ASSERT，无法识别返回LOG_INDEX_OTHER_LEVEL
+*/
+int
+LogIndexLevel(char c)
+{
+    switch (c) {
+    case 'V':
+        return 0;
+    case 'D':
+        return 1;
+    case 'I':
+        return 2;
+    case 'W':
+        return 3;
+    case 'E':
+        return 4;
+    case 'A':
+        return 5;
+    default:
+        return LOG_INDEX_OTHER_LEVEL;
+    }
+}
+
+/*
+* @brief      取日志文本的级别和模块ID
+* @note       文本格式为"[L][PID:..][file func][LINE:n]ID->:内容"，模块ID为"->:"前最后一个']'之后的部分
+* @param[in]  text    日志文本，不含时间戳前缀
+* @param[in]  len     文本长度
+* @param[out] level   级别
+* @param[out] tag     模块ID起始位置，无法识别时为NULL
+* @param[out] tag_len 模块ID长度
+* @return     无
+*/
+void
+LogIndexParse(const char* text, int len, int* level, const char** tag, int* tag_len)
+{
+    const char* arrow, *start;
+
+    *level = ((len >= 3) && (text[0] == '[') && (text[2] == ']')) ? LogIndexLevel(text[1]) : LOG_INDEX_OTHER_LEVEL;
+    *tag = NULL;
+    *tag_len = 0;
+    arrow = (const char* )memmem(text, len, "->:", 3);
+    if (arrow == NULL) {
+        return;
+    }
+    for (start = arrow; (start > text) && (start[-1] != ']'); start--) {
+    }
+    if (start > text) {
+        *tag = start;
+        *tag_len = arrow - start;
+    }
+}
+
+/*
+* @brief      模块ID的布隆过滤位
+* @note       每个模块ID置64位中的两位
+* @param[in]  tag     模块ID
+* @param[in]  len     长度
+* @return     过滤位
+*/
+uint64_t
+LogIndexTagBloom(const char* tag, int len)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)tag[i]) * 1099511628211ULL;
+    }
+    return (1ULL << (hash & 63)) | (1ULL << ((hash >> 6) & 63));
+}
+
+/*
+* @brief      一行加入当前块
+* @note       块为空时以该行偏移作为块起始；event_time为0的行(如版本行)不计入时间范围
+* @param[in]  block       当前块
+* @param[in]  offset      行在段文件中的偏移
+* @param[in]  line        行，含时间戳前缀和结尾'\n'
+* @param[in]  len         行长度
+* @param[in]  event_time  事件时间，微秒
+* @return     无
+*/
+void
+LogIndexAdd(LogIndexEntry* block, uint64_t offset, const char* line, int len, uint64_t event_time)
+{
+    const char* tag;
+    int level, tag_len;
+
+    if (block->length == 0) {
+        memset(block, 0, sizeof(*block));
+        block->offset = offset;
+        block->time_min = UINT64_MAX;
+    }
+    block->length += len;
+    if ((event_time == 0) || (len <= LOG_TIME_PREFIX_LEN)) {
+        return;
+    }
+
+    block->count++;
+    if (event_time < block->time_min) {
+        block->time_min = event_time;
+    }
+    if (event_time > block->time_max) {
+        block->time_max = event_time;
+    }
+    LogIndexParse(line + LOG_TIME_PREFIX_LEN, len - LOG_TIME_PREFIX_LEN - 1, &level, &tag, &tag_len);
+    block->level_mask |= 1u << level;
+    if (tag != NULL) {
+        block->tag_bloom |= LogIndexTagBloom(tag, tag_len);
+    }
+}
+
+/*
+* @brief      读取定长十进制数
+* @note
+* @param[in]  s       字符串
+* @param[in]  width   位数
+* @return     数值，含非数字字符返回-1
+*/
+static int
+LogIndexDigits(const char* s, int width)
+{
+    int value = 0, i;
+
+    for (i = 0; i < width; i++) {
+        if ((s[i] < '0') || (s[i] > '9')) {
+            return -1;
+        }
+        value = value * 10 + (s[i] - '0');
+    }
+    return value;
+}
+
+/*
+* @brief      公历日期到1970-01-01的天数
+* @note
+* @param[in]  y       年
+* @param[in]  m       月
+* @param[in]  d       日
+* @return     天数
+*/
+static int64_t
+LogIndexDays(int y, int m, int d)
+{
+    int64_t era, yoe, doy, doe;
+
+    y -= (m <= 2);
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/*
+* @brief      解析时间字符串
+* @note       格式"YYYY-MM-DD HH:MM:SS"，可带".uuuuuu"，按LOG_TIME_ZONE换算
+* @param[in]  s       时间字符串
+* @param[in]  len     可读长度
+* @param[out] time    自1970年起的微秒数
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      格式错误
+*/
+int
+LogIndexParseTime(const char* s, int len, uint64_t* time)
+{
+    static const int width[6] = {4, 2, 2, 2, 2, 2};
+    static const char sep[6] = {'-', '-', ' ', ':', ':', '\0'};
+    int value[6], pos = 0, usec = 0, scale = 100000, i;
+    int64_t sec;
+
+    for (i = 0; i < 6; i++) {
+        if ((pos + width[i] > len) || ((value[i] = LogIndexDigits(s + pos, width[i])) < 0)) {
+            return -1;
+        }
+        pos += width[i];
+        if (sep[i] != '\0') {
+            if ((pos >= len) || (s[pos] != sep[i])) {
+                return -1;
+            }
+            pos++;
+        }
+    }
+    if ((value[1] < 1) || (value[1] > 12) || (value[2] < 1) || (value[2] > 31) ||
+        (value[3] > 23) || (value[4] > 59) || (value[5] > 60)) {
+        return -1;
+    }
+    if ((pos < len) && (s[pos] == '.')) {
+        for (pos++; (pos < len) && (scale > 0) && (s[pos] >= '0') && (s[pos] <= '9'); pos++) {
+            usec += (s[pos] - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    sec = LogIndexDays(value[0], value[1], value[2]) * 86400 + value[3] * 3600 + value[4] * 60 + value[5];
+    sec -= LOG_TIME_ZONE * 3600;
+    if (sec < 0) {
+        return -1;
+    }
+    *time = (uint64_t)sec * 1000000 + usec;
+    return 0;
+}
+
+/*
+* @brief      判断是否为滚动文件
+* @note       滚动文件名为"日志名.时间"，压缩后加".gz"；旧版本滚动为"日志名1"~"日志名N"，数字越大越旧；
+*             索引文件不算
+* @param[in]  name    文件名
+* @param[in]  base    日志文件名
+* @return     0不是滚动文件，1滚动文件，2旧版本滚动文件
+*/
+int
+LogIndexRolled(const char* name, const char* base)
+{
+    size_t base_len = strlen(base), len = strlen(name), suffix_len = strlen(LOG_INDEX_SUFFIX);
+    const char* p = name + base_len;
+
+    if (strncmp(name, base, base_len) != 0) {
+        return 0;
+    }
+    if ((*p >= '1') && (*p <= '9')) {
+        while ((*p >= '0') && (*p <= '9')) {
+            p++;
+        }
+        return (*p == '\0') ? 2 : 0;
+    }
+    if ((*p != '.') || (p[1] == '\0') ||
+        ((len >= suffix_len) && (strcmp(name + len - suffix_len, LOG_INDEX_SUFFIX) == 0))) {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* @brief      比较两个滚动文件的先后
+* @note       旧版本滚动文件都早于带时间的滚动文件，之间按数字从大到小；带时间的按文件名
+* @param[in]  a       文件名
+* @param[in]  b       文件名
+* @param[in]  base_len    日志文件名长度
+* @return     a先滚动返回负数
+*/
+int
+LogIndexRolledCompare(const char* a, const char* b, size_t base_len)
+{
+    int a_old = (a[base_len] >= '0') && (a[base_len] <= '9');
+    int b_old = (b[base_len] >= '0') && (b[base_len] <= '9');
+    long a_number, b_number;
+
+    if (a_old != b_old) {
+        return a_old ? -1 : 1;
+    }
+    if (!a_old) {
+        return strcmp(a, b);
+    }
+    a_number = strtol(a + base_len, NULL, 10);
+    b_number = strtol(b + base_len, NULL, 10);
+    return (a_number > b_number) ? -1 : (a_number < b_number);
+}
@@ -0,0 +1,143 @@
+/*
+* @file      logIndex.h
+* @brief     日志段索引头文件
+*
+* 每个日志段(当前日志文件和滚动文件)旁有一个".idx"稀疏索引，按块记录偏移、时间范围、
+* 出现的级别和模块ID的布隆过滤，查询时只读命中的块；守护进程和logQuery共用本文件
+* gcc avic_log.c logBinary.c logUring.c logArchive.c logIndex.c ../MessageQueue/shmQueue.c ../MessageQueue/queue.c -lpthread -lz -o avic
+* gcc logQuery.c logIndex.c -lz -o logQuery
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __LOG_INDEX_H__INCLUDE_
+#define __LOG_INDEX_H__INCLUDE_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+    //---- 宏定义开始 ----//
+#define LOG_INDEX_MAGIC         "AVICIDX1"      /* 索引文件头 */
+#define LOG_INDEX_SUFFIX        ".idx"          /* 索引文件名后缀 */
+#define LOG_INDEX_BLOCK         (32 * 1024)     /* 块长度达到该值后开始新块 */
+#define LOG_TIME_ZONE           8               /* 日志时间戳的时区，使用北京时间 */
+#define LOG_TIME_PREFIX_LEN     29              /* "[YYYY-MM-DD HH:MM:SS.uuuuuu]:"长度 */
+#define LOG_INDEX_OTHER_LEVEL   15              /* 无法识别级别的行在level_mask中的位 */
+    //---- 宏定义结束 ----//
+
+    /* ---- 结构体定义开始 ---- */
+/*
+* @brief 索引文件头
+*/
+typedef struct LogIndexHead{
+    char      magic[8];                                 /* LOG_INDEX_MAGIC */
+    uint32_t  entry_size;                               /* sizeof(LogIndexEntry)，用于校验 */
+    uint32_t  reserved;
+}LogIndexHead;
+
+/*
+* @brief 索引项，一个块一项
+* @note  块由整行组成，偏移为段文件未压缩时的偏移
+*/
+typedef struct LogIndexEntry{
+    uint64_t  offset;                                   /* 块起始偏移 */
+    uint64_t  time_min;                                 /* 块内最早事件时间，微秒 */
+    uint64_t  time_max;                                 /* 块内最晚事件时间，微秒 */
+    uint64_t  tag_bloom;                                /* 块内模块ID的布隆过滤 */
+    uint32_t  length;                                   /* 块长度 */
+    uint16_t  level_mask;                               /* 块内出现的级别，按LogIndexLevel取位 */
+    uint16_t  count;                                    /* 块内行数 */
+}LogIndexEntry;
+    /* ---- 结构体定义结束 ---- */
+
+    /* ---- 函数声明开始 ---- */
+/*
+* @brief      级别字符转级别
+* @note
+* @param[in]  c       日志文本中的级别字符
+* @return     0~5对应VERBOSE~ASSERT，无法识别返回LOG_INDEX_OTHER_LEVEL
+*/
+int LogIndexLevel(char );
+
+/*
+* @brief      取日志文本的级别和模块ID
+* @note       文本格式为"[L][PID:..][file func][LINE:n]ID->:内容"，模块ID为"->:"前最后一个']'之后的部分
+* @param[in]  text    日志文本，不含时间戳前缀
+* @param[in]  len     文本长度
+* @param[out] level   级别
+* @param[out] tag     模块ID起始位置，无法识别时为NULL
+* @param[out] tag_len 模块ID长度
+* @return     无
+*/
+void LogIndexParse(const char* , int , int* , const char** , int* );
+
+/*
+* @brief      模块ID的布隆过滤位
+* @note       每个模块ID置64位中的两位
+* @param[in]  tag     模块ID
+* @param[in]  len     长度
+* @return     过滤位
+*/
+uint64_t LogIndexTagBloom(const char* , int );
+
+/*
+* @brief      一行加入当前块
+* @note       块为空时以该行偏移作为块起始；event_time为0的行(如版本行)不计入时间范围
+* @param[in]  block       当前块
+* @param[in]  offset      行在段文件中的偏移
+* @param[in]  line        行，含时间戳前缀和结尾'\n'
+* @param[in]  len         行长度
+* @param[in]  event_time  事件时间，微秒
+* @return     无
+*/
+void LogIndexAdd(LogIndexEntry* , uint64_t , const char* , int , uint64_t );
+
+/*
+* @brief      解析时间字符串
+* @note       格式"YYYY-MM-DD HH:MM:SS"，可带".uuuuuu"，按LOG_TIME_ZONE换算
+* @param[in]  s       时间字符串
+* @param[in]  len     可读长度
+* @param[out] time    自1970年起的微秒数
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      格式错误
+*/
+int LogIndexParseTime(const char* , int , uint64_t* );
+
+/*
+* @brief      判断是否为滚动文件
+* @note       滚动文件名为"日志名.时间"，压缩后加".gz"；旧版本滚动为"日志名1"~"日志名N"，数字越大越旧；
+*             索引文件不算
+* @param[in]  name    文件名
+* @param[in]  base    日志文件名
+* @return     0不是滚动文件，1滚动文件，2旧版本滚动文件
+*/
+int LogIndexRolled(const char* , const char* );
+
+/*
+* @brief      比较两个滚动文件的先后
+* @note       旧版本滚动文件都早于带时间的滚动文件，之间按数字从大到小；带时间的按文件名
+* @param[in]  a       文件名
+* @param[in]  b       文件名
+* @param[in]  base_len    日志文件名长度
+* @return     a先滚动返回负数
+*/
+int LogIndexRolledCompare(const char* , const char* , size_t );
+    /* ---- 函数声明结束 ---- */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,529 @@
+/*
+* @file      logQuery.c
+* @brief     日志查询工具
+*
+* 按时间范围、最低级别和模块ID查询日志目录中的日志段；借助".idx"稀疏索引只读取可能命中的块，
+* 未压缩的日志段通过mmap读取，.gz日志段只解压到最后一个需要的块；没有索引的部分逐行过滤
+* gcc -O2 logQuery.c logIndex.c -lz -o logQuery
+* 例: ./logQuery -b "2026-10-19 12:00:00" -e "2026-10-19 12:05:00" -l W -g LOG
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "logIndex.h"
+
+#if defined(__has_include)
+#if __has_include(<zlib.h>)
+#define LOG_HAVE_ZLIB           1
+#include <zlib.h>
+#endif
+#endif
+
+#define LOG_FOLDER_NAME     "log/"              /* 日志目录，与守护进程一致 */
+#define LOG_FILE_NAME       "log"               /* 文件名称，与守护进程一致 */
+
+/*
+* @brief 查询条件
+*/
+typedef struct LogQuery{
+    uint64_t    begin;                                  /* 最早事件时间，微秒，0不限 */
+    uint64_t    end;                                    /* 最晚事件时间，微秒，UINT64_MAX不限 */
+    int         level;                                  /* 最低级别，0不限 */
+    const char* tag;                                    /* 模块ID，NULL不限 */
+    int         tag_len;
+    uint64_t    tag_bloom;                              /* 模块ID的布隆过滤位 */
+    uint16_t    level_mask;                             /* 满足最低级别的级别位 */
+    int         filter;                                 /* 1表示有查询条件，可以使用索引 */
+    int         verbose;                                /* 1表示向stderr输出读取量 */
+    uint64_t    total;                                  /* 日志段总长度 */
+    uint64_t    scanned;                                /* 实际逐行过滤的长度 */
+}LogQueryData;
+
+/*
+* @brief 日志段内容
+*/
+typedef struct LogSegment{
+    char*       data;                                   /* 内容 */
+    uint64_t    size;                                   /* 可读长度 */
+    int         mapped;                                 /* 1表示mmap，否则malloc */
+}LogSegmentData;
+
+/*
+* @brief 索引文件映射
+*/
+typedef struct LogIndexMap{
+    void*                   map;                        /* 文件映射 */
+    size_t                  map_len;
+    const LogIndexEntry*    entries;                    /* 索引项 */
+    int                     number;                     /* 索引项个数 */
+}LogIndexMapData;
+
+/*
+* @brief      判断一行是否满足查询条件
+* @note       时间取自行首时间戳前缀，级别和模块ID按LogIndexParse解析
+* @param[in]  q       查询条件
+* @param[in]  line    行，不含'\n'
+* @param[in]  len     行长度
+* @return     1满足，0不满足
+*/
+static int LogQueryMatch(const LogQueryData* q, const char* line, int len)
+{
+    const char* tag;
+    int level, tag_len;
+    uint64_t event_time;
+
+    if (!q->filter) {
+        return 1;
+    }
+    if ((len < LOG_TIME_PREFIX_LEN) || (line[0] != '[') ||
+        (LogIndexParseTime(line + 1, LOG_TIME_PREFIX_LEN - 1, &event_time) != 0) ||
+        (event_time < q->begin) || (event_time > q->end)) {
+        return 0;
+    }
+    LogIndexParse(line + LOG_TIME_PREFIX_LEN, len - LOG_TIME_PREFIX_LEN, &level, &tag, &tag_len);
+    if ((level == LOG_INDEX_OTHER_LEVEL) || (level < q->level)) {
+        return 0;
+    }
+    if ((q->tag != NULL) && ((tag_len != q->tag_len) || (memcmp(tag, q->tag, tag_len) != 0))) {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+* @brief      逐行过滤一段内容
+* @note       起止位置都在行首；最后一行可能正在写入，没有'\n'时也输出
+* @param[in]  q       查询条件
+* @param[in]  data    日志段内容
+* @param[in]  begin   起始偏移
+* @param[in]  end     结束偏移
+* @return     无
+*/
+static void LogQueryScan(LogQueryData* q, const char* data, uint64_t begin, uint64_t end)
+{
+    const char* line = data + begin, *stop = data + end, *next;
+
+    q->scanned += end - begin;
+    while (line < stop) {
+        next = (const char* )memchr(line, '\n', stop - line);
+        next = (next == NULL) ? stop : next + 1;
+        if (LogQueryMatch(q, line, (int)(next - line) - ((next[-1] == '\n') ? 1 : 0))) {
+            fwrite(line, 1, next - line, stdout);
+        }
+        line = next;
+    }
+}
+
+/*
+* @brief      判断索引项是否可能包含满足条件的行
+* @note
+* @param[in]  q       查询条件
+* @param[in]  e       索引项
+* @return     1可能包含，0一定不包含
+*/
+static int LogQueryBlock(const LogQueryData* q, const LogIndexEntry* e)
+{
+    if (!q->filter) {
+        return 1;
+    }
+    return (e->count > 0) && (e->time_max >= q->begin) && (e->time_min <= q->end) &&
+           ((e->level_mask & q->level_mask) != 0) &&
+           ((e->tag_bloom & q->tag_bloom) == q->tag_bloom);
+}
+
+/*
+* @brief      映射日志段的索引文件
+* @note       索引文件为日志段路径去掉".gz"后加LOG_INDEX_SUFFIX；文件头不符时当作没有索引
+* @param[in]  path    日志段路径
+* @param[out] idx     索引
+* @return     无
+*/
+static void LogIndexMapOpen(const char* path, LogIndexMapData* idx)
+{
+    char idx_path[PATH_MAX + 16];
+    const LogIndexHead* head;
+    size_t len = strlen(path);
+    struct stat st;
+    int fd;
+
+    memset(idx, 0, sizeof(*idx));
+    if ((len > 3) && (strcmp(path + len - 3, ".gz") == 0)) {
+        len -= 3;
+    }
+    snprintf(idx_path, sizeof(idx_path), "%.*s%s", (int)len, path, LOG_INDEX_SUFFIX);
+    fd = open(idx_path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(LogIndexHead))) {
+        idx->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (idx->map == MAP_FAILED) {
+            idx->map = NULL;
+        } else {
+            idx->map_len = st.st_size;
+        }
+    }
+    close(fd);
+    if (idx->map == NULL) {
+        return;
+    }
+    head = (const LogIndexHead* )idx->map;
+    if ((memcmp(head->magic, LOG_INDEX_MAGIC, sizeof(head->magic)) != 0) ||
+        (head->entry_size != sizeof(LogIndexEntry))) {
+        munmap(idx->map, idx->map_len);
+        memset(idx, 0, sizeof(*idx));
+        return;
+    }
+    idx->entries = (const LogIndexEntry* )(head + 1);
+    idx->number = (idx->map_len - sizeof(LogIndexHead)) / sizeof(LogIndexEntry);
+}
+
+/*
+* @brief      取日志段未压缩长度
+* @note       .gz文件取gzip尾部记录的长度，日志段远小于4GB
+* @param[in]  path    日志段路径
+* @param[in]  gz      1表示.gz文件
+* @param[out] size    未压缩长度
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      失败
+*/
+static int LogSegmentSize(const char* path, int gz, uint64_t* size)
+{
+    unsigned char tail[4];
+    struct stat st;
+    int fd, ret = -1;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) == 0) {
+        if (!gz) {
+            *size = st.st_size;
+            ret = 0;
+        } else if ((st.st_size >= 18) && (pread(fd, tail, sizeof(tail), st.st_size - 4) == sizeof(tail))) {
+            *size = (uint64_t)tail[0] | ((uint64_t)tail[1] << 8) | ((uint64_t)tail[2] << 16) | ((uint64_t)tail[3] << 24);
+            ret = 0;
+        }
+    }
+    close(fd);
+    return ret;
+}
+
+/*
+* @brief      读取日志段
+* @note       未压缩文件mmap，.gz文件解压前need字节到内存
+* @param[in]  path    日志段路径
+* @param[in]  gz      1表示.gz文件
+* @param[in]  need    需要的长度
+* @param[out] seg     日志段内容
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      失败
+*/
+static int LogSegmentLoad(const char* path, int gz, uint64_t need, LogSegmentData* seg)
+{
+    int fd;
+
+    memset(seg, 0, sizeof(*seg));
+    if (need == 0) {
+        return 0;
+    }
+    if (!gz) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return -1;
+        }
+        seg->data = (char* )mmap(NULL, need, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (seg->data == MAP_FAILED) {
+            seg->data = NULL;
+            return -1;
+        }
+        madvise(seg->data, need, MADV_RANDOM);
+        seg->size = need;
+        seg->mapped = 1;
+        return 0;
+    }
+#ifdef LOG_HAVE_ZLIB
+    gzFile in = gzopen(path, "rb");
+    int n;
+
+    if (in == NULL) {
+        return -1;
+    }
+    seg->data = (char* )malloc(need);
+    if (seg->data == NULL) {
+        gzclose(in);
+        return -1;
+    }
+    while ((seg->size < need) && ((n = gzread(in, seg->data + seg->size, need - seg->size)) > 0)) {
+        seg->size += n;
+    }
+    gzclose(in);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+* @brief      释放日志段内容
+*/
+static void LogSegmentFree(LogSegmentData* seg)
+{
+    if (seg->data == NULL) {
+        return;
+    }
+    if (seg->mapped) {
+        munmap(seg->data, seg->size);
+    } else {
+        free(seg->data);
+    }
+}
+
+/*
+* @brief      查询一个日志段
+* @note       按索引项顺序处理：命中的块和索引项之间的空隙逐行过滤，不命中的块跳过；
+*             最后一个索引项之后(当前块尚未写入索引或守护进程异常退出)逐行过滤到文件末尾
+* @param[in]  q       查询条件
+* @param[in]  path    日志段路径
+* @return     无
+*/
+static void LogQuerySegment(LogQueryData* q, const char* path)
+{
+    size_t len = strlen(path);
+    int gz = (len > 3) && (strcmp(path + len - 3, ".gz") == 0);
+    uint64_t size, need = 0, pos = 0, begin, end;
+    LogIndexMapData idx;
+    LogSegmentData seg;
+    int i;
+
+    if (LogSegmentSize(path, gz, &size) != 0) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return;
+    }
+    q->total += size;
+    LogIndexMapOpen(path, &idx);
+
+    /* 先算出需要读取的长度，.gz文件只解压到这里 */
+    for (i = 0; i < idx.number; i++) {
+        begin = idx.entries[i].offset;
+        end = begin + idx.entries[i].length;
+        if ((begin < pos) || (begin >= size)) {
+            break;
+        }
+        if ((begin > pos) || LogQueryBlock(q, &(idx.entries[i]))) {
+            need = (end < size) ? end : size;
+        }
+        pos = end;
+    }
+    if ((i < idx.number) || (pos < size)) {
+        need = size;
+    }
+
+    if (LogSegmentLoad(path, gz, need, &seg) != 0) {
+        fprintf(stderr, "%s: cannot load\n", path);
+    } else {
+        pos = 0;
+        for (i = 0; (i < idx.number) && (pos < seg.size); i++) {
+            begin = idx.entries[i].offset;
+            end = begin + idx.entries[i].length;
+            if (begin < pos) {
+                break;
+            }
+            if (begin > pos) {
+                LogQueryScan(q, seg.data, pos, (begin < seg.size) ? begin : seg.size);
+            }
+            if ((begin < seg.size) && LogQueryBlock(q, &(idx.entries[i]))) {
+                LogQueryScan(q, seg.data, begin, (end < seg.size) ? end : seg.size);
+            }
+            pos = (end < seg.size) ? end : seg.size;
+        }
+        if (pos < seg.size) {
+            LogQueryScan(q, seg.data, pos, seg.size);
+        }
+        LogSegmentFree(&seg);
+    }
+    if (idx.map != NULL) {
+        munmap(idx.map, idx.map_len);
+    }
+}
+
+/*
+* @brief      按滚动先后比较，旧版本的"log1"~"logN"在前
+*/
+static int LogQueryCompare(const void* a, const void* b)
+{
+    return LogIndexRolledCompare(*(char* const* )a, *(char* const* )b, strlen(LOG_FILE_NAME));
+}
+
+/*
+* @brief      查询日志目录
+* @note       依次查询旧版本滚动文件、滚动文件和当前日志文件，跳过索引文件和压缩中的临时文件
+* @param[in]  q       查询条件
+* @param[in]  folder  日志目录，以'/'结尾
+* @return     无
+*/
+static void LogQueryFolder(LogQueryData* q, const char* folder)
+{
+    char path[PATH_MAX + NAME_MAX + 1];
+    char** names = NULL, **tmp;
+    int number = 0, capcity = 0, i;
+    struct dirent* entry;
+    size_t len;
+    DIR* dir;
+
+    dir = opendir(folder);
+    if (dir == NULL) {
+        fprintf(stderr, "%s: cannot open\n", folder);
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        len = strlen(entry->d_name);
+        if ((LogIndexRolled(entry->d_name, LOG_FILE_NAME) == 0) ||
+            ((len >= 4) && (strcmp(entry->d_name + len - 4, ".tmp") == 0))) {
+            continue;
+        }
+        if (number == capcity) {
+            capcity = (capcity == 0) ? 64 : capcity * 2;
+            tmp = (char** )realloc(names, capcity * sizeof(char* ));
+            if (tmp == NULL) {
+                break;
+            }
+            names = tmp;
+        }
+        names[number] = strdup(entry->d_name);
+        if (names[number] != NULL) {
+            number++;
+        }
+    }
+    closedir(dir);
+
+    qsort(names, number, sizeof(char* ), LogQueryCompare);
+    for (i = 0; i < number; i++) {
+        snprintf(path, sizeof(path), "%s%s", folder, names[i]);
+        LogQuerySegment(q, path);
+        free(names[i]);
+    }
+    free(names);
+    snprintf(path, sizeof(path), "%s%s", folder, LOG_FILE_NAME);
+    if (access(path, F_OK) == 0) {
+        LogQuerySegment(q, path);
+    }
+}
+
+/*
+* @brief      获取默认日志目录
+* @note       与守护进程相同，为可执行文件所在目录下的LOG_FOLDER_NAME
+* @param[out] path    日志目录
+* @param[in]  size    缓存大小
+* @return     无
+*/
+static void LogQueryDefaultFolder(char* path, int size)
+{
+    char exe[PATH_MAX];
+    ssize_t count = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    char* slash;
+
+    if (count <= 0) {
+        snprintf(path, size, "%s", LOG_FOLDER_NAME);
+        return;
+    }
+    exe[count] = '\0';
+    slash = strrchr(exe, '/');
+    slash[1] = '\0';
+    snprintf(path, size, "%s%s", exe, LOG_FOLDER_NAME);
+}
+
+int main(int argc, char *argv[])
+{
+    LogQueryData q;
+    char folder[PATH_MAX + 16];
+    int ret, i;
+    size_t len;
+
+    memset(&q, 0, sizeof(q));
+    q.end = UINT64_MAX;
+    folder[0] = '\0';
+
+    /* -b/-e时间范围"YYYY-MM-DD HH:MM:SS[.uuuuuu]"，-e不带微秒时包含整秒；-l最低级别V/D/I/W/E/A；
+       -g模块ID；-d日志目录；-v向stderr输出读取量；其余参数为要查询的日志段，不指定时查询整个目录 */
+    while ((ret = getopt(argc, argv, "b:e:l:g:d:v")) != -1) {
+        switch (ret) {
+        case 'b':
+        case 'e':
+            len = strlen(optarg);
+            if (LogIndexParseTime(optarg, len, (ret == 'b') ? &(q.begin) : &(q.end)) != 0) {
+                fprintf(stderr, "bad time: %s\n", optarg);
+                return -1;
+            }
+            if ((ret == 'e') && (len == 19)) {
+                q.end += 999999;
+            }
+            q.filter = 1;
+            break;
+        case 'l':
+            q.level = LogIndexLevel(optarg[0]);
+            if (q.level == LOG_INDEX_OTHER_LEVEL) {
+                fprintf(stderr, "bad level: %s\n", optarg);
+                return -1;
+            }
+            q.filter = 1;
+            break;
+        case 'g':
+            q.tag = optarg;
+            q.tag_len = strlen(optarg);
+            q.tag_bloom = LogIndexTagBloom(q.tag, q.tag_len);
+            q.filter = 1;
+            break;
+        case 'd':
+            snprintf(folder, sizeof(folder), "%s/", optarg);
+            break;
+        case 'v':
+            q.verbose = 1;
+            break;
+        default:
+            printf("usage: %s [-b begin] [-e end] [-l level] [-g tag] [-d folder] [-v] [file...]\n", argv[0]);
+            return -1;
+        }
+    }
+    for (i = q.level; i < LOG_INDEX_OTHER_LEVEL; i++) {
+        q.level_mask |= 1u << i;
+    }
+
+    if (optind < argc) {
+        for (i = optind; i < argc; i++) {
+            LogQuerySegment(&q, argv[i]);
+        }
+    } else {
+        if (folder[0] == '\0') {
+            LogQueryDefaultFolder(folder, sizeof(folder));
+        }
+        LogQueryFolder(&q, folder);
+    }
+    fflush(stdout);
+    if (q.verbose) {
+        fprintf(stderr, "scanned %llu of %llu bytes\n",
+                (unsigned long long)q.scanned, (unsigned long long)q.total);
+    }
+    return 0;
+}
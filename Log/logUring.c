@@ -0,0 +1,305 @@
+/*
+* @file      logUring.c
+* @brief     io_uring写文件源文件
+*
+* 提交队列、完成队列的映射和读写；头尾下标用__atomic内建函数与内核同步
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "logUring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LOG_HAVE_URING          1
+#endif
+#endif
+
+#ifdef LOG_HAVE_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/*
+* @brief      取一个空闲的提交队列项
+* @note
+* @param[in]  u       io_uring实例
+* @return     提交队列项，队列满返回NULL
+*/
+static struct io_uring_sqe* LogUringGetSqe(LogUringData* u)
+{
+    struct io_uring_sqe* sqe;
+    unsigned head = __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *(u->sq_tail);
+    unsigned index;
+
+    if (tail - head >= u->sq_entries) {
+        return NULL;
+    }
+    index = tail & *(u->sq_mask);
+    sqe = (struct io_uring_sqe* )u->sqes + index;
+    memset(sqe, 0, sizeof(*sqe));
+    u->sq_array[index] = index;
+    return sqe;
+}
+
+/*
+* @brief      发布提交队列项并通知内核
+* @note       io_uring_enter失败时请求留在队列中，下次收割时再提交
+* @param[in]  u       io_uring实例
+* @return     无
+*/
+static void LogUringSubmit(LogUringData* u)
+{
+    int ret;
+
+    __atomic_store_n(u->sq_tail, *(u->sq_tail) + 1, __ATOMIC_RELEASE);
+    u->to_submit++;
+    ret = syscall(__NR_io_uring_enter, u->ring_fd, u->to_submit, 0, 0, NULL, 0);
+    if (ret > 0) {
+        u->to_submit -= ret;
+    }
+}
+
+/*
+* @brief      创建io_uring实例并注册写缓存
+* @note       注册失败(如锁定内存受限)时仍可用，写入改用非固定缓存
+* @param[out] u           io_uring实例
+* @param[in]  bufs        写缓存数组，可为NULL
+* @param[in]  buf_number  写缓存个数
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      内核不支持或创建失败
+*/
+int LogUringInit(LogUringData* u, const struct iovec* bufs, int buf_number)
+{
+    struct io_uring_params p;
+
+    memset(u, 0, sizeof(*u));
+    memset(&p, 0, sizeof(p));
+    u->ring_fd = syscall(__NR_io_uring_setup, LOG_URING_ENTRIES, &p);
+    if (u->ring_fd < 0) {
+        return -1;
+    }
+
+    u->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_len > u->sq_len) {
+            u->sq_len = u->cq_len;
+        }
+        u->cq_len = u->sq_len;
+    }
+    u->sq_ptr = mmap(NULL, u->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     u->ring_fd, IORING_OFF_SQ_RING);
+    if (u->sq_ptr == MAP_FAILED) {
+        u->sq_ptr = NULL;
+        LogUringExit(u);
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ptr = u->sq_ptr;
+    } else {
+        u->cq_ptr = mmap(NULL, u->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         u->ring_fd, IORING_OFF_CQ_RING);
+        if (u->cq_ptr == MAP_FAILED) {
+            u->cq_ptr = NULL;
+            LogUringExit(u);
+            return -1;
+        }
+    }
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   u->ring_fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        u->sqes = NULL;
+        LogUringExit(u);
+        return -1;
+    }
+
+    u->sq_entries = p.sq_entries;
+    u->sq_head = (unsigned* )((char* )u->sq_ptr + p.sq_off.head);
+    u->sq_tail = (unsigned* )((char* )u->sq_ptr + p.sq_off.tail);
+    u->sq_mask = (unsigned* )((char* )u->sq_ptr + p.sq_off.ring_mask);
+    u->sq_array = (unsigned* )((char* )u->sq_ptr + p.sq_off.array);
+    u->cq_head = (unsigned* )((char* )u->cq_ptr + p.cq_off.head);
+    u->cq_tail = (unsigned* )((char* )u->cq_ptr + p.cq_off.tail);
+    u->cq_mask = (unsigned* )((char* )u->cq_ptr + p.cq_off.ring_mask);
+    u->cqes = (char* )u->cq_ptr + p.cq_off.cqes;
+
+    /* 注册后内核不必每次请求都映射用户缓存 */
+    if ((bufs != NULL) && (buf_number > 0)) {
+        u->registered = (syscall(__NR_io_uring_register, u->ring_fd, IORING_REGISTER_BUFFERS,
+                                 bufs, buf_number) == 0);
+    }
+    return 0;
+}
+
+/*
+* @brief      提交写请求
+* @note       按指定偏移写入，多个请求完成顺序不影响文件内容
+* @param[in]  u           io_uring实例
+* @param[in]  fd          文件句柄
+* @param[in]  buf_index   注册缓存下标，-1表示非注册缓存
+* @param[in]  buf         数据
+* @param[in]  len         数据长度
+* @param[in]  offset      文件偏移
+* @param[in]  user_data   用户数据，完成时原样返回
+* @return     执行结果
+* @retval     0       已放入提交队列
+* @retval     -1      提交队列满
+*/
+int LogUringWrite(LogUringData* u, int fd, int buf_index, const void* buf, unsigned len,
+                  uint64_t offset, uint64_t user_data)
+{
+    struct io_uring_sqe* sqe = LogUringGetSqe(u);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    if (u->registered && (buf_index >= 0)) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->buf_index = buf_index;
+    } else {
+        sqe->opcode = IORING_OP_WRITE;
+    }
+    sqe->fd = fd;
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    LogUringSubmit(u);
+    return 0;
+}
+
+/*
+* @brief      提交fdatasync请求
+* @note       等之前提交的写请求全部完成后才执行
+* @param[in]  u           io_uring实例
+* @param[in]  fd          文件句柄
+* @param[in]  user_data   用户数据，完成时原样返回
+* @return     执行结果
+* @retval     0       已放入提交队列
+* @retval     -1      提交队列满
+*/
+int LogUringSync(LogUringData* u, int fd, uint64_t user_data)
+{
+    struct io_uring_sqe* sqe = LogUringGetSqe(u);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->flags = IOSQE_IO_DRAIN;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    LogUringSubmit(u);
+    return 0;
+}
+
+/*
+* @brief      收割完成事件
+* @note       同时提交尚未被内核取走的请求
+* @param[in]  u       io_uring实例
+* @param[in]  wait    1表示没有完成事件时阻塞等待至少一个
+* @param[out] events  完成事件数组
+* @param[in]  max     数组长度
+* @return     完成事件个数
+*/
+int LogUringReap(LogUringData* u, int wait, LogUringEvent* events, int max)
+{
+    struct io_uring_cqe* cqe;
+    unsigned head, tail;
+    int ret, number = 0;
+
+    head = *(u->cq_head);
+    tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    if ((u->to_submit > 0) || (wait && (head == tail))) {
+        ret = syscall(__NR_io_uring_enter, u->ring_fd, u->to_submit, (head == tail) ? wait : 0,
+                      wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (ret > 0) {
+            u->to_submit -= ret;
+        }
+        tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    }
+    while ((head != tail) && (number < max)) {
+        cqe = (struct io_uring_cqe* )u->cqes + (head & *(u->cq_mask));
+        events[number].user_data = cqe->user_data;
+        events[number].res = cqe->res;
+        number++;
+        head++;
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    return number;
+}
+
+/*
+* @brief      释放io_uring实例
+* @note       未完成的请求由内核继续执行
+* @param[in]  u       io_uring实例
+* @return     无
+*/
+void LogUringExit(LogUringData* u)
+{
+    if (u->sqes != NULL) {
+        munmap(u->sqes, u->sqes_len);
+    }
+    if ((u->cq_ptr != NULL) && (u->cq_ptr != u->sq_ptr)) {
+        munmap(u->cq_ptr, u->cq_len);
+    }
+    if (u->sq_ptr != NULL) {
+        munmap(u->sq_ptr, u->sq_len);
+    }
+    if (u->ring_fd >= 0) {
+        close(u->ring_fd);
+    }
+    memset(u, 0, sizeof(*u));
+    u->ring_fd = -1;
+}
+
+#else
+
+int LogUringInit(LogUringData* u, const struct iovec* bufs, int buf_number)
+{
+    (void)bufs;
+    (void)buf_number;
+    memset(u, 0, sizeof(*u));
+    u->ring_fd = -1;
+    return -1;
+}
+
+int LogUringWrite(LogUringData* u, int fd, int buf_index, const void* buf, unsigned len,
+                  uint64_t offset, uint64_t user_data)
+{
+    (void)u; (void)fd; (void)buf_index; (void)buf; (void)len; (void)offset; (void)user_data;
+    return -1;
+}
+
+int LogUringSync(LogUringData* u, int fd, uint64_t user_data)
+{
+    (void)u; (void)fd; (void)user_data;
+    return -1;
+}
+
+int LogUringReap(LogUringData* u, int wait, LogUringEvent* events, int max)
+{
+    (void)u; (void)wait; (void)events; (void)max;
+    return 0;
+}
+
+void LogUringExit(LogUringData* u)
+{
+    (void)u;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+* @file      logUring.h
+* @brief     io_uring写文件头文件
+*
+* 日志守护进程的异步写文件接口，直接使用io_uring系统调用，不依赖liburing；
+* 内核或头文件不支持时LogUringInit返回-1，由调用者改用pwrite
+* gcc avic_log.c logBinary.c logUring.c logArchive.c logIndex.c ../MessageQueue/shmQueue.c ../MessageQueue/queue.c -lpthread -lz -o avic
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __LOG_URING_H__INCLUDE_
+#define __LOG_URING_H__INCLUDE_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+    //---- 宏定义开始 ----//
+#define LOG_URING_ENTRIES       16              /* 提交队列长度 */
+    //---- 宏定义结束 ----//
+
+    /* ---- 结构体定义开始 ---- */
+/*
+* @brief 完成事件
+*/
+typedef struct LogUringEvent{
+    uint64_t  user_data;                                /* 提交时的用户数据 */
+    int32_t   res;                                      /* 写入字节数或负的错误码 */
+}LogUringEvent;
+
+/*
+* @brief io_uring实例
+* @note  提交和收割都在调用者的锁内进行，不支持多线程并发访问
+*/
+typedef struct LogUring{
+    int        ring_fd;                                 /* io_uring句柄 */
+    int        registered;                              /* 写缓存是否已注册 */
+    unsigned   sq_entries;                              /* 提交队列长度 */
+    unsigned   to_submit;                               /* 已放入提交队列但内核尚未取走的个数 */
+    unsigned*  sq_head;
+    unsigned*  sq_tail;
+    unsigned*  sq_mask;
+    unsigned*  sq_array;
+    unsigned*  cq_head;
+    unsigned*  cq_tail;
+    unsigned*  cq_mask;
+    void*      sqes;                                    /* 提交队列项数组 */
+    void*      cqes;                                    /* 完成队列项数组 */
+    void*      sq_ptr;                                  /* 提交队列映射 */
+    size_t     sq_len;
+    void*      cq_ptr;                                  /* 完成队列映射，与提交队列共用时等于sq_ptr */
+    size_t     cq_len;
+    size_t     sqes_len;
+}LogUringData;
+    /* ---- 结构体定义结束 ---- */
+
+    /* ---- 函数声明开始 ---- */
+/*
+* @brief      创建io_uring实例并注册写缓存
+* @note       注册失败(如锁定内存受限)时仍可用，写入改用非固定缓存
+* @param[out] u           io_uring实例
+* @param[in]  bufs        写缓存数组，可为NULL
+* @param[in]  buf_number  写缓存个数
+* @return     执行结果
+* @retval     0       成功
+* @retval     -1      内核不支持或创建失败
+*/
+int LogUringInit(LogUringData* , const struct iovec* , int );
+
+/*
+* @brief      提交写请求
+* @note       按指定偏移写入，多个请求完成顺序不影响文件内容
+* @param[in]  u           io_uring实例
+* @param[in]  fd          文件句柄
+* @param[in]  buf_index   注册缓存下标，-1表示非注册缓存
+* @param[in]  buf         数据
+* @param[in]  len         数据长度
+* @param[in]  offset      文件偏移
+* @param[in]  user_data   用户数据，完成时原样返回
+* @return     执行结果
+* @retval     0       已放入提交队列
+* @retval     -1      提交队列满
+*/
+int LogUringWrite(LogUringData* , int , int , const void* , unsigned , uint64_t , uint64_t );
+
+/*
+* @brief      提交fdatasync请求
+* @note       等之前提交的写请求全部完成后才执行
+* @param[in]  u           io_uring实例
+* @param[in]  fd          文件句柄
+* @param[in]  user_data   用户数据，完成时原样返回
+* @return     执行结果
+* @retval     0       已放入提交队列
+* @retval     -1      提交队列满
+*/
+int LogUringSync(LogUringData* , int , uint64_t );
+
+/*
+* @brief      收割完成事件
+* @note       同时提交尚未被内核取走的请求
+* @param[in]  u       io_uring实例
+* @param[in]  wait    1表示没有完成事件时阻塞等待至少一个
+* @param[out] events  完成事件数组
+* @param[in]  max     数组长度
+* @return     完成事件个数
+*/
+int LogUringReap(LogUringData* , int , LogUringEvent* , int );
+
+/*
+* @brief      释放io_uring实例
+* @note       未完成的请求由内核继续执行
+* @param[in]  u       io_uring实例
+* @return     无
+*/
+void LogUringExit(LogUringData* );
+    /* ---- 函数声明结束 ---- */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,358 @@
+/**
+* @file      broadcastQueue.c
+* @brief     广播队列源文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include "broadcastQueue.h"
+#define DEFAULT_SIZE    1024
+
+/*
+* @brief      计算截止时间
+* @note       条件变量使用单调时钟
+* @param[in]  tv   相对超时时间
+* @param[out] ts   截止时间
+* @return     无
+*/
+static void BroadcastQueueDeadline(const struct timeval* tv, struct timespec* ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += tv->tv_sec;
+    ts->tv_nsec += tv->tv_usec * 1000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec += ts->tv_nsec / 1000000000;
+        ts->tv_nsec %= 1000000000;
+    }
+}
+
+/*
+* @brief      是否已过截止时间
+* @note       忙等和让出策略使用
+* @param[in]  ts   截止时间
+* @return     1    已超时
+* @return     0    未超时
+*/
+static int BroadcastQueueExpired(const struct timespec* ts)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > ts->tv_sec || (now.tv_sec == ts->tv_sec && now.tv_nsec >= ts->tv_nsec);
+}
+
+/*
+* @brief      唤醒阻塞等待者
+* @note       全序屏障保证：要么看到等待者并唤醒，要么等待者在挂起前能看到新状态
+* @param[in]  q        队列结构体
+* @param[in]  waiters  等待者数
+* @param[in]  cond     条件变量
+* @return     无
+*/
+static void BroadcastQueueWake(BroadcastQueueData* q, int* waiters, pthread_cond_t* cond)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiters, __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&(q->m_mutex));
+        pthread_cond_broadcast(cond);
+        pthread_mutex_unlock(&(q->m_mutex));
+    }
+}
+
+/*
+* @brief      最慢订阅者的读序号
+* @note       没有订阅者时返回next，生产者不受限制
+* @param[in]  q     队列结构体
+* @param[in]  next  生产者下一个发布序号
+* @return     最小读序号
+*/
+static size_t BroadcastQueueMinSequence(BroadcastQueueData* q, size_t next)
+{
+    size_t min = next, seq;
+    int i;
+
+    for (i = 0; i < BROADCAST_MAX_SUBSCRIBERS; i++) {
+        if (__atomic_load_n(&(q->subscribers[i].active), __ATOMIC_ACQUIRE)) {
+            seq = __atomic_load_n(&(q->subscribers[i].sequence), __ATOMIC_ACQUIRE);
+            if ((long)(seq - min) < 0) {
+                min = seq;
+            }
+        }
+    }
+    return min;
+}
+
+/*
+* @brief      广播队列创建
+* @note       容量向上取整为2的幂
+* @param[in]  size      队列长度
+* @param[in]  strategy  等待策略
+* @return     队列指针
+*/
+BroadcastQueueData* BroadcastQueueCreate(int size, BroadcastWaitStrategy strategy)
+{
+    BroadcastQueueData* q = NULL;
+    pthread_condattr_t attr;
+    size_t capcity = 2;
+    int i;
+
+    if (size <= 0) {
+        size = DEFAULT_SIZE;
+    }
+    while (capcity < (size_t)size) {
+        capcity <<= 1;
+    }
+
+    /* 按缓存行对齐，保证生产者和各订阅者序号不共享缓存行 */
+    if (posix_memalign((void** )&q, CACHE_LINE_SIZE, sizeof(BroadcastQueueData)) != 0) {
+        return NULL;
+    }
+    q->buf = (void** )malloc(capcity * sizeof(void* ));
+    if (q->buf == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->mask = capcity - 1;
+    q->wait_strategy = strategy;
+    q->publish = 0;
+    q->gating_cache = 0;
+    for (i = 0; i < BROADCAST_MAX_SUBSCRIBERS; i++) {
+        q->subscribers[i].sequence = 0;
+        q->subscribers[i].active = 0;
+    }
+    q->wait_pthread = 0;
+    q->wait_producer = 0;
+
+    pthread_mutex_init(&(q->m_mutex), NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(q->m_cond), &attr);
+    pthread_cond_init(&(q->m_space_cond), &attr);
+    pthread_condattr_destroy(&attr);
+    return q;
+}
+
+/*
+* @brief      订阅
+* @note       从订阅时刻之后发布的消息开始接收
+* @param[in]  q    队列结构体
+* @return     订阅者编号
+* @return     -1   订阅者已满
+*/
+int BroadcastQueueSubscribe(BroadcastQueueData* q)
+{
+    BroadcastCursor* cursor;
+    int i;
+
+    if (q == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&(q->m_mutex));
+    for (i = 0; i < BROADCAST_MAX_SUBSCRIBERS; i++) {
+        cursor = &(q->subscribers[i]);
+        if (!cursor->active) {
+            __atomic_store_n(&(cursor->sequence), __atomic_load_n(&(q->publish), __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+            __atomic_store_n(&(cursor->active), 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            /* 生产者可能没看到本订阅者，按其可见之后的发布序号重新起步，避免读到被覆盖的槽位 */
+            __atomic_store_n(&(cursor->sequence), __atomic_load_n(&(q->publish), __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&(q->m_mutex));
+            return i;
+        }
+    }
+    pthread_mutex_unlock(&(q->m_mutex));
+    return -1;
+}
+
+/*
+* @brief      取消订阅
+* @note       取消后不再限制生产者
+* @param[in]  q    队列结构体
+* @param[in]  id   订阅者编号
+* @return     0    成功
+* @return     -1   失败
+*/
+int BroadcastQueueUnsubscribe(BroadcastQueueData* q, int id)
+{
+    if (q == NULL || id < 0 || id >= BROADCAST_MAX_SUBSCRIBERS) {
+        return -1;
+    }
+    pthread_mutex_lock(&(q->m_mutex));
+    __atomic_store_n(&(q->subscribers[id].active), 0, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&(q->m_space_cond));
+    pthread_mutex_unlock(&(q->m_mutex));
+    return 0;
+}
+
+/*
+* @brief      发布消息
+* @note       最慢订阅者未读完时按等待策略等待；没有订阅者时消息直接丢弃
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     -1   失败
+*/
+int BroadcastQueuePublish(BroadcastQueueData* q, void* data)
+{
+    size_t next, capcity;
+
+    if (q == NULL) {
+        return -1;
+    }
+    next = q->publish;
+    capcity = q->mask + 1;
+
+    /* 缓存的最慢序号不够用时才扫描订阅者 */
+    while (next - q->gating_cache >= capcity) {
+        q->gating_cache = BroadcastQueueMinSequence(q, next);
+        if (next - q->gating_cache < capcity) {
+            break;
+        }
+        if (q->wait_strategy == BroadcastWaitBusy) {
+            continue;
+        }
+        if (q->wait_strategy == BroadcastWaitYield) {
+            sched_yield();
+            continue;
+        }
+        pthread_mutex_lock(&(q->m_mutex));
+        __atomic_store_n(&(q->wait_producer), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        q->gating_cache = BroadcastQueueMinSequence(q, next);
+        if (next - q->gating_cache >= capcity) {
+            pthread_cond_wait(&(q->m_space_cond), &(q->m_mutex));
+        }
+        __atomic_store_n(&(q->wait_producer), 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(q->m_mutex));
+    }
+
+    q->buf[next & q->mask] = data;
+    __atomic_store_n(&(q->publish), next + 1, __ATOMIC_RELEASE);
+
+    if (q->wait_strategy == BroadcastWaitBlock) {
+        BroadcastQueueWake(q, &(q->wait_pthread), &(q->m_cond));
+    }
+    return 0;
+}
+
+/*
+* @brief      批量接收消息
+* @note       取出本订阅者所有已发布的消息，最多max个，只更新一次读序号
+* @param[in]  q    队列结构体
+* @param[in]  id   订阅者编号
+* @param[out] out  数据数组
+* @param[in]  max  最多取出个数
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     取出个数，超时返回0
+* @return     -1   失败
+*/
+int BroadcastQueueReceiveBatch(BroadcastQueueData* q, int id, void** out, int max, struct timeval* tv)
+{
+    BroadcastCursor* cursor;
+    struct timespec ts;
+    size_t seq, avail, i;
+    int timeout = 0;
+
+    if (q == NULL || id < 0 || id >= BROADCAST_MAX_SUBSCRIBERS || out == NULL || max <= 0) {
+        return -1;
+    }
+    cursor = &(q->subscribers[id]);
+    seq = cursor->sequence;
+    if (tv != NULL) {
+        BroadcastQueueDeadline(tv, &ts);
+    }
+
+    for (;;) {
+        avail = __atomic_load_n(&(q->publish), __ATOMIC_ACQUIRE) - seq;
+        if (avail > 0) {
+            break;
+        }
+        if (tv != NULL && (timeout || (tv->tv_sec == 0 && tv->tv_usec == 0))) {
+            return 0;
+        }
+        if (q->wait_strategy == BroadcastWaitBusy) {
+            timeout = tv != NULL && BroadcastQueueExpired(&ts);
+            continue;
+        }
+        if (q->wait_strategy == BroadcastWaitYield) {
+            sched_yield();
+            timeout = tv != NULL && BroadcastQueueExpired(&ts);
+            continue;
+        }
+        pthread_mutex_lock(&(q->m_mutex));
+        __atomic_add_fetch(&(q->wait_pthread), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&(q->publish), __ATOMIC_ACQUIRE) == seq) {
+            if (tv == NULL) {
+                pthread_cond_wait(&(q->m_cond), &(q->m_mutex));
+            } else if (pthread_cond_timedwait(&(q->m_cond), &(q->m_mutex), &ts) == ETIMEDOUT) {
+                timeout = 1;
+            }
+        }
+        __atomic_sub_fetch(&(q->wait_pthread), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(q->m_mutex));
+    }
+
+    if (avail > (size_t)max) {
+        avail = (size_t)max;
+    }
+    for (i = 0; i < avail; i++) {
+        out[i] = q->buf[(seq + i) & q->mask];
+    }
+    __atomic_store_n(&(cursor->sequence), seq + avail, __ATOMIC_RELEASE);
+
+    if (q->wait_strategy == BroadcastWaitBlock) {
+        BroadcastQueueWake(q, &(q->wait_producer), &(q->m_space_cond));
+    }
+    return (int)avail;
+}
+
+/*
+* @brief      接收一条消息
+* @note
+* @param[in]  q    队列结构体
+* @param[in]  id   订阅者编号
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
+*/
+void* BroadcastQueueReceive(BroadcastQueueData* q, int id, struct timeval* tv)
+{
+    void* data = NULL;
+
+    if (BroadcastQueueReceiveBatch(q, id, &data, 1, tv) != 1) {
+        return NULL;
+    }
+    return data;
+}
+
+/*
+* @brief      释放广播队列
+* @note
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int BroadcastQueueFree(BroadcastQueueData* q)
+{
+    if ((q == NULL) || (q->buf == NULL)) {
+        return -1;
+    }
+    free(q->buf);
+    q->buf = NULL;
+    pthread_mutex_destroy(&(q->m_mutex));
+    pthread_cond_destroy(&(q->m_cond));
+    pthread_cond_destroy(&(q->m_space_cond));
+    free(q);
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+* @file      broadcastQueue.h
+* @brief     广播队列头文件
+*
+* 一个生产者写入一个环形缓冲区，每个订阅者持有独立的读序号，都能收到全部消息；
+* 生产者受最慢订阅者限制，扇出只写一次
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#ifndef __BROADCAST_QUEUE_H__INCLUDE_
+#define __BROADCAST_QUEUE_H__INCLUDE_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE     64          /* 缓存行大小 */
+#endif
+
+#define BROADCAST_MAX_SUBSCRIBERS   16  /* 最多订阅者数 */
+
+/*
+* @brief      等待策略
+*/
+typedef enum {
+    BroadcastWaitBusy   = 0,            /* 忙等，延迟最低，占满CPU */
+    BroadcastWaitYield  = 1,            /* 让出CPU后重试 */
+    BroadcastWaitBlock  = 2             /* 条件变量阻塞 */
+} BroadcastWaitStrategy;
+
+/*
+* @brief      订阅者读序号
+* @note       每个订阅者独占一个缓存行
+*/
+typedef struct BroadcastCursor{
+    size_t  sequence;                   /* 下一个要读的序号 */
+    int     active;                     /* 是否在用 */
+    char    pad[CACHE_LINE_SIZE - sizeof(size_t) - sizeof(int)];
+}BroadcastCursor;
+
+/*
+* @brief      广播队列
+* @note       单生产者；多个线程发布时需要调用者自行加锁
+*/
+typedef struct BroadcastQueue{
+    void**              buf;                    /* 数据 */
+    size_t              mask;                   /* 容量减一，容量为2的幂 */
+    int                 wait_strategy;          /* 等待策略 */
+    char                pad0[CACHE_LINE_SIZE - sizeof(void**) - sizeof(size_t) - sizeof(int)];
+    size_t              publish;                /* 生产者：下一个发布序号 */
+    size_t              gating_cache;           /* 生产者：缓存的最慢订阅者序号 */
+    char                pad1[CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+    BroadcastCursor     subscribers[BROADCAST_MAX_SUBSCRIBERS];
+    pthread_mutex_t     m_mutex;                /* 阻塞等待和订阅管理 */
+    pthread_cond_t      m_cond;                 /* 有新消息 */
+    pthread_cond_t      m_space_cond;           /* 有空位 */
+    int                 wait_pthread;           /* 阻塞等待的订阅者数 */
+    int                 wait_producer;          /* 生产者阻塞等待 */
+}BroadcastQueueData;
+
+/*
+* @brief      广播队列创建
+* @note       容量向上取整为2的幂
+* @param[in]  size      队列长度
+* @param[in]  strategy  等待策略
+* @return     队列指针
+*/
+BroadcastQueueData* BroadcastQueueCreate(int , BroadcastWaitStrategy );
+
+/*
+* @brief      订阅
+* @note       从订阅时刻之后发布的消息开始接收
+* @param[in]  q    队列结构体
+* @return     订阅者编号
+* @return     -1   订阅者已满
+*/
+int BroadcastQueueSubscribe(BroadcastQueueData* );
+
+/*
+* @brief      取消订阅
+* @note       取消后不再限制生产者
+* @param[in]  q    队列结构体
+* @param[in]  id   订阅者编号
+* @return     0    成功
+* @return     -1   失败
+*/
+int BroadcastQueueUnsubscribe(BroadcastQueueData* , int );
+
+/*
+* @brief      发布消息
+* @note       最慢订阅者未读完时按等待策略等待；没有订阅者时消息直接丢弃
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     -1   失败
+*/
+int BroadcastQueuePublish(BroadcastQueueData* , void* );
+
+/*
+* @brief      批量接收消息
+* @note       取出本订阅者所有已发布的消息，最多max个，只更新一次读序号
+* @param[in]  q    队列结构体
+* @param[in]  id   订阅者编号
+* @param[out] out  数据数组
+* @param[in]  max  最多取出个数
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     取出个数，超时返回0
+* @return     -1   失败
+*/
+int BroadcastQueueReceiveBatch(BroadcastQueueData* , int , void** , int , struct timeval* );
+
+/*
+* @brief      接收一条消息
+* @note
+* @param[in]  q    队列结构体
+* @param[in]  id   订阅者编号
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
+*/
+void* BroadcastQueueReceive(BroadcastQueueData* , int , struct timeval* );
+
+/*
+* @brief      释放广播队列
+* @note
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int BroadcastQueueFree(BroadcastQueueData* );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+/**
+* @file      contentionBench.c
+* @brief     缓存行争用对比
+*
+* 对比生产者/消费者字段挤在同一缓存行(原先#pragma pack(1)布局)与分行布局的单生产者单消费者吞吐，
+* 并测量AsyncQueueData在2生产者2消费者下的吞吐；需在多核机器上运行才能看出差异
+* gcc -O2 -c queue.c && gcc -O2 contentionBench.c queue.o -lpthread
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "queue.h"
+
+#define CAPACITY    4096
+#define ITEMS       (10 * 1000 * 1000)
+#define THREADS     2
+
+#pragma pack(1)
+/*
+* @brief      原布局：头尾下标与只读字段同在一个缓存行
+*/
+typedef struct PackedRing{
+    void**          buf;
+    unsigned int    capcity;
+    unsigned int    header;
+    unsigned int    tail;
+}PackedRing;
+#pragma pack()
+
+/*
+* @brief      分行布局：只读字段、生产者、消费者各占一个缓存行
+*/
+typedef struct PaddedRing{
+    void**          buf;
+    unsigned int    capcity;
+    char            pad0[CACHE_LINE_SIZE - sizeof(void**) - sizeof(unsigned int)];
+    unsigned int    header;
+    char            pad1[CACHE_LINE_SIZE - sizeof(unsigned int)];
+    unsigned int    tail;
+    char            pad2[CACHE_LINE_SIZE - sizeof(unsigned int)];
+}PaddedRing;
+
+/* 两种布局共用的生产/消费循环，只有结构体类型不同 */
+#define RING_PRODUCER(type, name)                                                           \
+static void* name(void* arg)                                                                \
+{                                                                                           \
+    type* r = (type* )arg;                                                                  \
+    unsigned int i, head;                                                                   \
+    for (i = 1; i <= ITEMS; i++) {                                                          \
+        do {                                                                                \
+            head = __atomic_load_n(&(r->header), __ATOMIC_ACQUIRE);                         \
+        } while (r->tail - head == r->capcity);                                             \
+        r->buf[r->tail & (r->capcity - 1)] = (void* )(uintptr_t)i;                          \
+        __atomic_store_n(&(r->tail), r->tail + 1, __ATOMIC_RELEASE);                        \
+    }                                                                                       \
+    return NULL;                                                                            \
+}
+
+#define RING_CONSUMER(type, name)                                                           \
+static void* name(void* arg)                                                                \
+{                                                                                           \
+    type* r = (type* )arg;                                                                  \
+    unsigned int i, tail;                                                                   \
+    uint64_t sum = 0;                                                                       \
+    for (i = 0; i < ITEMS; i++) {                                                           \
+        do {                                                                                \
+            tail = __atomic_load_n(&(r->tail), __ATOMIC_ACQUIRE);                           \
+        } while (tail == r->header);                                                        \
+        sum += (uintptr_t)r->buf[r->header & (r->capcity - 1)];                             \
+        __atomic_store_n(&(r->header), r->header + 1, __ATOMIC_RELEASE);                    \
+    }                                                                                       \
+    return (void* )(uintptr_t)sum;                                                          \
+}
+
+RING_PRODUCER(PackedRing, PackedProducer)
+RING_CONSUMER(PackedRing, PackedConsumer)
+RING_PRODUCER(PaddedRing, PaddedProducer)
+RING_CONSUMER(PaddedRing, PaddedConsumer)
+
+/*
+* @brief      单调时钟，单位秒
+*/
+static double Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+* @brief      启动一对生产者消费者并打印吞吐
+* @param[in]  name      名称
+* @param[in]  producer  生产者线程函数
+* @param[in]  consumer  消费者线程函数
+* @param[in]  arg       队列
+* @param[in]  items     总元素个数
+*/
+static void RunPair(const char* name, void* (*producer)(void* ), void* (*consumer)(void* ),
+                   void* arg, double items)
+{
+    pthread_t p, c;
+    void* sum;
+    double start = Now(), cost;
+
+    pthread_create(&c, NULL, consumer, arg);
+    pthread_create(&p, NULL, producer, arg);
+    pthread_join(p, NULL);
+    pthread_join(c, &sum);
+    cost = Now() - start;
+    printf("%-28s %8.2f Mops/s  sum=%llu\n", name, items / cost / 1e6,
+           (unsigned long long)(uintptr_t)sum);
+}
+
+static void* AsyncProducer(void* arg)
+{
+    AsyncQueueData* mq = (AsyncQueueData* )arg;
+    int i;
+
+    for (i = 1; i <= ITEMS / THREADS; i++) {
+        AsyncQueuePushTail(mq, (void* )(uintptr_t)i);
+    }
+    return NULL;
+}
+
+static void* AsyncConsumer(void* arg)
+{
+    AsyncQueueData* mq = (AsyncQueueData* )arg;
+    uint64_t sum = 0;
+    int i;
+
+    for (i = 0; i < ITEMS / THREADS; i++) {
+        sum += (uintptr_t)AsyncQueuePopHead(mq, NULL);
+    }
+    return (void* )(uintptr_t)sum;
+}
+
+/*
+* @brief      AsyncQueueData多生产者多消费者吞吐
+*/
+static void RunAsync(void)
+{
+    AsyncQueueData* mq = AsyncQueueDataCreate(CAPACITY);
+    pthread_t p[THREADS], c[THREADS];
+    uint64_t sum = 0;
+    void* part;
+    double start = Now(), cost;
+    int i;
+
+    for (i = 0; i < THREADS; i++) {
+        pthread_create(&c[i], NULL, AsyncConsumer, mq);
+        pthread_create(&p[i], NULL, AsyncProducer, mq);
+    }
+    for (i = 0; i < THREADS; i++) {
+        pthread_join(p[i], NULL);
+        pthread_join(c[i], &part);
+        sum += (uintptr_t)part;
+    }
+    cost = Now() - start;
+    printf("%-28s %8.2f Mops/s  sum=%llu\n", "AsyncQueueData 2P/2C",
+           (double)ITEMS / cost / 1e6, (unsigned long long)sum);
+    AsyncQueueFree(mq);
+}
+
+int main(void)
+{
+    PackedRing* packed;
+    PaddedRing* padded;
+    void** buf = (void** )malloc(CAPACITY * sizeof(void* ));
+
+    if (buf == NULL ||
+        posix_memalign((void** )&packed, CACHE_LINE_SIZE, sizeof(PackedRing)) != 0) {
+        return -1;
+    }
+    if (posix_memalign((void** )&padded, CACHE_LINE_SIZE, sizeof(PaddedRing)) != 0) {
+        return -1;
+    }
+    packed->buf = padded->buf = buf;
+    packed->capcity = padded->capcity = CAPACITY;
+    packed->header = packed->tail = 0;
+    padded->header = padded->tail = 0;
+
+    printf("PackedRing %zu bytes, PaddedRing %zu bytes, AsyncQueueData %zu bytes\n",
+           sizeof(PackedRing), sizeof(PaddedRing), sizeof(AsyncQueueData));
+    RunPair("spsc packed (shared line)", PackedProducer, PackedConsumer, packed, ITEMS);
+    RunPair("spsc padded (split lines)", PaddedProducer, PaddedConsumer, padded, ITEMS);
+    RunAsync();
+
+    free(packed);
+    free(padded);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+* @file      msgBuffer.c
+* @brief     引用计数消息缓冲区源文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include "msgBuffer.h"
+#include "../DynamicMemoryPool/memPool.h"
+
+/*
+* @brief      分配消息缓冲区
+* @note       引用计数初始为1
+* @param[in]  pool  内存池，NULL时使用malloc
+* @param[in]  size  数据区容量
+* @return     缓冲区指针，失败返回NULL
+*/
+MsgBuffer* MsgBufferAlloc(mempool_alloc* pool, int size)
+{
+    MsgBuffer* buf;
+
+    if (size < 0) {
+        return NULL;
+    }
+    if (pool != NULL) {
+        buf = (MsgBuffer* )pool->mempool_alloc(pool, sizeof(MsgBuffer) + size);
+    } else {
+        buf = (MsgBuffer* )malloc(sizeof(MsgBuffer) + size);
+    }
+    if (buf == NULL) {
+        return NULL;
+    }
+    buf->refcount = 1;
+    buf->len = 0;
+    buf->capcity = size;
+    buf->pool = pool;
+    return buf;
+}
+
+/*
+* @brief      增加引用
+* @note       交给另一个消费者前调用
+* @param[in]  buf   缓冲区
+* @param[in]  n     增加的引用数，扇出给n个消费者时一次增加
+* @return     缓冲区指针
+*/
+MsgBuffer* MsgBufferRef(MsgBuffer* buf, int n)
+{
+    if (buf != NULL && n > 0) {
+        __atomic_add_fetch(&(buf->refcount), n, __ATOMIC_RELAXED);
+    }
+    return buf;
+}
+
+/*
+* @brief      释放引用
+* @note       最后一个引用释放时归还内存池
+* @param[in]  buf   缓冲区
+* @return     剩余引用数
+* @return     -1    失败
+*/
+int MsgBufferRelease(MsgBuffer* buf)
+{
+    int ref;
+
+    if (buf == NULL) {
+        return -1;
+    }
+    ref = __atomic_sub_fetch(&(buf->refcount), 1, __ATOMIC_RELEASE);
+    if (ref == 0) {
+        /* 其他持有者对数据的访问都发生在归还之前 */
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (buf->pool != NULL) {
+            buf->pool->mempool_free(buf);
+        } else {
+            free(buf);
+        }
+    }
+    return ref;
+}
+
+/*
+* @brief      当前引用数
+* @note       并发时为瞬时值
+* @param[in]  buf   缓冲区
+* @return     引用数
+*/
+int MsgBufferRefCount(MsgBuffer* buf)
+{
+    if (buf == NULL) {
+        return 0;
+    }
+    return __atomic_load_n(&(buf->refcount), __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,79 @@
+/**
+* @file      msgBuffer.h
+* @brief     引用计数消息缓冲区头文件
+*
+* 缓冲区从动态内存池分配，以指针在队列间传递，多个消费者共享同一份数据不复制，
+* 最后一个引用释放时归还内存池
+* gcc -c msgBuffer.c ../DynamicMemoryPool/memPool.c
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#ifndef __MSG_BUFFER_H__INCLUDE_
+#define __MSG_BUFFER_H__INCLUDE_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mempool_alloc;
+
+/*
+* @brief      消息缓冲区
+* @note       头部和数据一次分配；引用计数原子操作，数据在共享后只读
+*/
+typedef struct MsgBuffer{
+    int                     refcount;   /* 引用计数 */
+    int                     len;        /* 有效数据长度 */
+    int                     capcity;    /* 数据区容量 */
+    struct mempool_alloc*   pool;       /* 来源内存池，NULL表示malloc分配 */
+    char                    data[];     /* 数据 */
+}MsgBuffer;
+
+/*
+* @brief      分配消息缓冲区
+* @note       引用计数初始为1
+* @param[in]  pool  内存池，NULL时使用malloc
+* @param[in]  size  数据区容量
+* @return     缓冲区指针，失败返回NULL
+*/
+MsgBuffer* MsgBufferAlloc(struct mempool_alloc* , int );
+
+/*
+* @brief      增加引用
+* @note       交给另一个消费者前调用
+* @param[in]  buf   缓冲区
+* @param[in]  n     增加的引用数，扇出给n个消费者时一次增加
+* @return     缓冲区指针
+*/
+MsgBuffer* MsgBufferRef(MsgBuffer* , int );
+
+/*
+* @brief      释放引用
+* @note       最后一个引用释放时归还内存池
+* @param[in]  buf   缓冲区
+* @return     剩余引用数
+* @return     -1    失败
+*/
+int MsgBufferRelease(MsgBuffer* );
+
+/*
+* @brief      当前引用数
+* @note       并发时为瞬时值
+* @param[in]  buf   缓冲区
+* @return     引用数
+*/
+int MsgBufferRefCount(MsgBuffer* );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,297 @@
+/**
+* @file      priorityQueue.c
+* @brief     优先级队列源文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include <errno.h>
+#include <time.h>
+#include "priorityQueue.h"
+#define DEFAULT_SIZE    1024
+
+/* a先于b出队：优先级高者先出，同优先级序号小者先出 */
+#define PRIORITY_BEFORE(a, b)   (((a).priority > (b).priority) || \
+                                 (((a).priority == (b).priority) && ((a).sequence < (b).sequence)))
+
+/*
+* @brief      计算截止时间
+* @note       条件变量使用单调时钟
+* @param[in]  tv   相对超时时间
+* @param[out] ts   截止时间
+* @return     无
+*/
+static void PriorityQueueDeadline(const struct timeval* tv, struct timespec* ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += tv->tv_sec;
+    ts->tv_nsec += tv->tv_usec * 1000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec += ts->tv_nsec / 1000000000;
+        ts->tv_nsec %= 1000000000;
+    }
+}
+
+/*
+* @brief      等待条件变量
+* @note       调用者持有锁
+* @param[in]  q    队列结构体
+* @param[in]  cond 条件变量
+* @param[in]  ts   截止时间，NULL一直等待
+* @return     0    被唤醒
+* @return     -1   超时
+*/
+static int PriorityQueueWait(PriorityQueueData* q, pthread_cond_t* cond, const struct timespec* ts)
+{
+    if (ts == NULL) {
+        pthread_cond_wait(cond, &(q->m_mutex));
+        return 0;
+    }
+    return pthread_cond_timedwait(cond, &(q->m_mutex), ts) == ETIMEDOUT ? -1 : 0;
+}
+
+/*
+* @brief      上浮
+* @note       空位逐层上移，最后一次写入节点
+* @param[in]  heap  堆数组
+* @param[in]  pos   起始位置
+* @param[in]  node  插入节点
+* @return     无
+*/
+static void PriorityHeapUp(PriorityNode* heap, int pos, PriorityNode node)
+{
+    int parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / PRIORITY_HEAP_ARITY;
+        if (!PRIORITY_BEFORE(node, heap[parent])) {
+            break;
+        }
+        heap[pos] = heap[parent];
+        pos = parent;
+    }
+    heap[pos] = node;
+}
+
+/*
+* @brief      下沉
+* @note       每层在最多4个子节点中选最小者
+* @param[in]  heap  堆数组
+* @param[in]  size  元素个数
+* @param[in]  node  从堆顶下沉的节点
+* @return     无
+*/
+static void PriorityHeapDown(PriorityNode* heap, int size, PriorityNode node)
+{
+    int pos = 0, child, best, last, i;
+
+    for (;;) {
+        child = pos * PRIORITY_HEAP_ARITY + 1;
+        if (child >= size) {
+            break;
+        }
+        last = child + PRIORITY_HEAP_ARITY;
+        if (last > size) {
+            last = size;
+        }
+        best = child;
+        for (i = child + 1; i < last; i++) {
+            if (PRIORITY_BEFORE(heap[i], heap[best])) {
+                best = i;
+            }
+        }
+        if (!PRIORITY_BEFORE(heap[best], node)) {
+            break;
+        }
+        heap[pos] = heap[best];
+        pos = best;
+    }
+    heap[pos] = node;
+}
+
+/*
+* @brief      优先级队列创建
+* @note
+* @param[in]  size    队列长度
+* @return     队列指针
+*/
+PriorityQueueData* PriorityQueueCreate(int size)
+{
+    pthread_condattr_t attr;
+    PriorityQueueData* q;
+
+    if (size <= 0) {
+        size = DEFAULT_SIZE;
+    }
+    q = (PriorityQueueData* )malloc(sizeof(PriorityQueueData));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->heap = (PriorityNode* )malloc(size * sizeof(PriorityNode));
+    if (q->heap == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->size = 0;
+    q->capcity = size;
+    q->sequence = 0;
+    q->wait_pthread = 0;
+    q->wait_push_pthread = 0;
+
+    pthread_mutex_init(&(q->m_mutex), NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(q->m_cond), &attr);
+    pthread_cond_init(&(q->m_full_cond), &attr);
+    pthread_condattr_destroy(&attr);
+    return q;
+}
+
+/*
+* @brief      插入元素
+* @note       队列满时阻塞等待，超时按单调时钟计算
+* @param[in]  q         队列结构体
+* @param[in]  data      数据
+* @param[in]  priority  优先级，数值大者先出
+* @param[in]  tv        超时时间，NULL一直等待，0不等待
+* @return     0    成功
+* @return     -1   失败或超时
+*/
+int PriorityQueuePush(PriorityQueueData* q, void* data, int priority, struct timeval* tv)
+{
+    PriorityNode node;
+    struct timespec ts;
+
+    if (q == NULL) {
+        return -1;
+    }
+    if (tv != NULL) {
+        PriorityQueueDeadline(tv, &ts);
+    }
+
+    pthread_mutex_lock(&(q->m_mutex));
+    while (q->size == q->capcity) {
+        if (tv != NULL && tv->tv_sec == 0 && tv->tv_usec == 0) {
+            pthread_mutex_unlock(&(q->m_mutex));
+            return -1;
+        }
+        q->wait_push_pthread++;
+        if (PriorityQueueWait(q, &(q->m_full_cond), tv != NULL ? &ts : NULL) != 0 &&
+            q->size == q->capcity) {
+            q->wait_push_pthread--;
+            pthread_mutex_unlock(&(q->m_mutex));
+            return -1;
+        }
+        q->wait_push_pthread--;
+    }
+
+    node.priority = priority;
+    node.sequence = q->sequence++;
+    node.data = data;
+    PriorityHeapUp(q->heap, q->size++, node);
+
+    if (q->wait_pthread > 0) {
+        pthread_cond_signal(&(q->m_cond));
+    }
+    pthread_mutex_unlock(&(q->m_mutex));
+    return 0;
+}
+
+/*
+* @brief      取出优先级最高的元素
+* @note       队列空时阻塞等待，超时按单调时钟计算
+* @param[in]  q         队列结构体
+* @param[out] priority  元素优先级，可为NULL
+* @param[in]  tv        超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
+*/
+void* PriorityQueuePop(PriorityQueueData* q, int* priority, struct timeval* tv)
+{
+    PriorityNode top;
+    struct timespec ts;
+
+    if (q == NULL) {
+        return NULL;
+    }
+    if (tv != NULL) {
+        PriorityQueueDeadline(tv, &ts);
+    }
+
+    pthread_mutex_lock(&(q->m_mutex));
+    while (q->size == 0) {
+        if (tv != NULL && tv->tv_sec == 0 && tv->tv_usec == 0) {
+            pthread_mutex_unlock(&(q->m_mutex));
+            return NULL;
+        }
+        q->wait_pthread++;
+        if (PriorityQueueWait(q, &(q->m_cond), tv != NULL ? &ts : NULL) != 0 && q->size == 0) {
+            q->wait_pthread--;
+            pthread_mutex_unlock(&(q->m_mutex));
+            return NULL;
+        }
+        q->wait_pthread--;
+    }
+
+    top = q->heap[0];
+    q->size--;
+    if (q->size > 0) {
+        PriorityHeapDown(q->heap, q->size, q->heap[q->size]);
+    }
+
+    if (q->wait_push_pthread > 0) {
+        pthread_cond_signal(&(q->m_full_cond));
+    }
+    pthread_mutex_unlock(&(q->m_mutex));
+
+    if (priority != NULL) {
+        *priority = top.priority;
+    }
+    return top.data;
+}
+
+/*
+* @brief      队列元素个数
+* @note
+* @param[in]  q    队列结构体
+* @return     元素个数
+*/
+int PriorityQueueSize(PriorityQueueData* q)
+{
+    int size;
+
+    if (q == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&(q->m_mutex));
+    size = q->size;
+    pthread_mutex_unlock(&(q->m_mutex));
+    return size;
+}
+
+/*
+* @brief      释放优先级队列
+* @note
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int PriorityQueueFree(PriorityQueueData* q)
+{
+    if ((q == NULL) || (q->heap == NULL)) {
+        return -1;
+    }
+    free(q->heap);
+    q->heap = NULL;
+    pthread_mutex_destroy(&(q->m_mutex));
+    pthread_cond_destroy(&(q->m_cond));
+    pthread_cond_destroy(&(q->m_full_cond));
+    free(q);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+* @file      priorityQueue.h
+* @brief     优先级队列头文件
+*
+* 连续数组上的4叉堆，插入和取出O(log n)；阻塞语义与AsyncQueueData相同
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#ifndef __PRIORITY_QUEUE_H__INCLUDE_
+#define __PRIORITY_QUEUE_H__INCLUDE_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PRIORITY_HEAP_ARITY     4       /* 堆的叉数，4叉堆层数约为二叉堆的一半，子节点在数组中相邻 */
+
+/*
+* @brief      堆节点
+*/
+typedef struct PriorityNode{
+    int         priority;               /* 优先级，数值大者先出 */
+    uint64_t    sequence;               /* 插入序号，同优先级小者先出，64位不会回绕 */
+    void*       data;                   /* 数据 */
+}PriorityNode;
+
+/*
+* @brief      优先级队列
+* @note       优先级数值大者先出，同优先级先进先出
+*/
+typedef struct PriorityQueue{
+    pthread_mutex_t     m_mutex;                /* 线程互斥锁 */
+    pthread_cond_t      m_cond;                 /* 非空条件变量 */
+    pthread_cond_t      m_full_cond;            /* 非满条件变量 */
+    int                 wait_pthread;           /* 等待取出的线程数量 */
+    int                 wait_push_pthread;      /* 等待放入的线程数量 */
+    PriorityNode*       heap;                   /* 堆数组 */
+    int                 size;                   /* 元素个数 */
+    int                 capcity;                /* 容量 */
+    uint64_t            sequence;               /* 插入序号 */
+}PriorityQueueData;
+
+/*
+* @brief      优先级队列创建
+* @note
+* @param[in]  size    队列长度
+* @return     队列指针
+*/
+PriorityQueueData* PriorityQueueCreate(int );
+
+/*
+* @brief      插入元素
+* @note       队列满时阻塞等待，超时按单调时钟计算
+* @param[in]  q         队列结构体
+* @param[in]  data      数据
+* @param[in]  priority  优先级，数值大者先出
+* @param[in]  tv        超时时间，NULL一直等待，0不等待
+* @return     0    成功
+* @return     -1   失败或超时
+*/
+int PriorityQueuePush(PriorityQueueData* , void* , int , struct timeval* );
+
+/*
+* @brief      取出优先级最高的元素
+* @note       队列空时阻塞等待，超时按单调时钟计算
+* @param[in]  q         队列结构体
+* @param[out] priority  元素优先级，可为NULL
+* @param[in]  tv        超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
+*/
+void* PriorityQueuePop(PriorityQueueData* , int* , struct timeval* );
+
+/*
+* @brief      队列元素个数
+* @note
+* @param[in]  q    队列结构体
+* @return     元素个数
+*/
+int PriorityQueueSize(PriorityQueueData* );
+
+/*
+* @brief      释放优先级队列
+* @note
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int PriorityQueueFree(PriorityQueueData* );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
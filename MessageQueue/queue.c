@@ -12,29 +12,123 @@
 * | ------- | ---- | ------ | ----------- |
 * | 1.0.0 | 2021-4-22 | xh | create |
 */
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/eventfd.h>
 #include "queue.h"
 #define DEFAULT_SIZE    1024
 
+#ifdef QUEUE_STATS
+/*
+* @brief      单调时钟纳秒
+* @note
+* @return     纳秒
+*/
+static uint64_t QueueStatsNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+* @brief      原子更新最大值
+* @note
+* @param[in]  max    最大值
+* @param[in]  value  新值
+* @return     无
+*/
+static void QueueStatsMax(uint64_t* max, uint64_t value)
+{
+    uint64_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+    while (value > old &&
+           !__atomic_compare_exchange_n(max, &old, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/*
+* @brief      记录入队
+* @note       写入槽位时间戳并更新峰值深度，调用者随后发布槽位
+* @param[in]  q    队列结构体
+* @param[in]  cell 槽位
+* @param[in]  pos  入队位置
+* @param[in]  now  当前时间
+* @return     无
+*/
+static void QueueStatsPush(MpmcQueueData* q, MpmcCell* cell, size_t pos, uint64_t now)
+{
+    cell->stamp = now;
+    QueueStatsMax(&(q->peak_depth), pos + 1 - __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED));
+}
+
+/*
+* @brief      记录出队
+* @note       按逗留时间的二进制位数归入直方图
+* @param[in]  q    队列结构体
+* @param[in]  cell 槽位
+* @param[in]  now  当前时间
+* @return     无
+*/
+static void QueueStatsPop(MpmcQueueData* q, MpmcCell* cell, uint64_t now)
+{
+    uint64_t sojourn = now > cell->stamp ? now - cell->stamp : 0;
+    int bucket = 63 - __builtin_clzll(sojourn | 1);
+
+    if (bucket >= QUEUE_STATS_BUCKETS) {
+        bucket = QUEUE_STATS_BUCKETS - 1;
+    }
+    __atomic_add_fetch(&(q->sojourn_hist[bucket]), 1, __ATOMIC_RELAXED);
+    QueueStatsMax(&(q->sojourn_max_ns), sojourn);
+}
+
+/*
+* @brief      记录一次等待
+* @note
+* @param[in]  count  等待次数
+* @param[in]  total  等待总时长
+* @param[in]  start  开始等待时间
+* @return     无
+*/
+static void QueueStatsWaited(unsigned long* count, uint64_t* total, uint64_t start)
+{
+    __atomic_add_fetch(count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(total, QueueStatsNow() - start, __ATOMIC_RELAXED);
+}
+#endif
+
 /*
 * @brief      环形队列创建
-* @note       
+* @note       容量向上取整为2的幂
 * @param[in]  size    队列长度
 * @return     队列指针
 * @retval     无
 */
 QueueData* QueueCreate(int size)
 {
-    QueueData* q = (QueueData* )malloc(sizeof(QueueData));
-    if (q != NULL) {
-        if (size > 0) {
-            q->buf = malloc(size);
-            q->capcity = size;
-        } else {
-            q->buf = malloc(DEFAULT_SIZE * sizeof(void *)); /* 8*1024 */
-            q->capcity = DEFAULT_SIZE;
-        }
-        q->header = q->tail = q->size = 0;
+    unsigned int capcity = 2;
+    QueueData* q = NULL;
+
+    /* 按缓存行对齐，保证头部和尾部不共享缓存行 */
+    if (posix_memalign((void** )&q, CACHE_LINE_SIZE, sizeof(QueueData)) != 0) {
+        return NULL;
+    }
+    if (size <= 0) {
+        size = DEFAULT_SIZE;
     }
+    /* 容量取2的幂，下标用掩码回绕代替取模 */
+    while (capcity < (unsigned int)size) {
+        capcity <<= 1;
+    }
+    q->buf = (void** )malloc(capcity * sizeof(void *));
+    if (q->buf == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->capcity = capcity;
+    q->header = q->tail = 0;
     return q;
 }
 
@@ -47,7 +141,7 @@ QueueData* QueueCreate(int size)
 */
 int QueueIsFull(QueueData* q)
 {
-    return q->size == q->capcity;
+    return q->tail - q->header == q->capcity;
 }
 
 /*
@@ -59,7 +153,7 @@ int QueueIsFull(QueueData* q)
 */
 int QueueIsEmpty(QueueData* q)
 {
-    return q->size == 0;
+    return q->tail == q->header;
 }
 
 /*
@@ -68,7 +162,7 @@ int QueueIsEmpty(QueueData* q)
 * @param[in]  q    队列结构体
 * @param[in]  data 数据
 * @return     0    成功
-* @return     -1   失败
+* @return     -1   失败，队列满
 */
 int QueuePushTail(QueueData* q, void* data)
 {
@@ -76,11 +170,12 @@ int QueuePushTail(QueueData* q, void* data)
         return -1;
     }
 
-    if (!QueueIsFull(q)) {
-        q->buf[q->tail] = data;
-        q->tail = (q->tail + 1) % q->capcity;
-        q->size++;
+    /* 队列满时返回失败，不再静默丢弃；需要无界队列使用SegQueueData */
+    if (QueueIsFull(q)) {
+        return -1;
     }
+    q->buf[q->tail & (q->capcity - 1)] = data;
+    q->tail++;
     return 0;
 }
 
@@ -94,9 +189,8 @@ void* QueuePopHead(QueueData* q)
 {
     void* data = NULL;
     if (!QueueIsEmpty(q)) {
-        data = q->buf[q->header];
-        q->header = (q->header + 1) % q->capcity;
-        q->size--;        
+        data = q->buf[q->header & (q->capcity - 1)];
+        q->header++;
     }
    
     return data;
@@ -121,6 +215,344 @@ int QueueFree(QueueData* q)
     return 0;
 }
 
+/*
+* @brief      无锁队列创建
+* @note       容量向上取整为2的幂
+* @param[in]  size    队列长度
+* @return     队列指针
+*/
+MpmcQueueData* MpmcQueueCreate(int size)
+{
+    MpmcQueueData* q = NULL;
+    size_t capcity = 2, i;
+
+    if (size <= 0) {
+        size = DEFAULT_SIZE;
+    }
+    while (capcity < (size_t)size) {
+        capcity <<= 1;
+    }
+
+    /* 按缓存行对齐，保证入队和出队位置不共享缓存行 */
+    if (posix_memalign((void** )&q, CACHE_LINE_SIZE, sizeof(MpmcQueueData)) != 0) {
+        return NULL;
+    }
+    q->buf = (MpmcCell* )malloc(capcity * sizeof(MpmcCell));
+    if (q->buf == NULL) {
+        free(q);
+        return NULL;
+    }
+    for (i = 0; i < capcity; i++) {
+        q->buf[i].sequence = i;
+        q->buf[i].data = NULL;
+    }
+    q->mask = capcity - 1;
+    q->enqueue_pos = 0;
+    q->dequeue_pos = 0;
+#ifdef QUEUE_STATS
+    q->peak_depth = 0;
+    q->sojourn_max_ns = 0;
+    memset(q->sojourn_hist, 0, sizeof(q->sojourn_hist));
+#endif
+    return q;
+}
+
+/*
+* @brief      无锁队列尾部插入元素
+* @note       不阻塞
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     -1   队列满
+*/
+int MpmcQueueTryPush(MpmcQueueData* q, void* data)
+{
+    MpmcCell* cell;
+    size_t pos, seq;
+    long dif;
+
+    pos = __atomic_load_n(&(q->enqueue_pos), __ATOMIC_RELAXED);
+    for (;;) {
+        cell = &(q->buf[pos & q->mask]);
+        seq = __atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE);
+        dif = (long)seq - (long)pos;
+        if (dif == 0) {
+            /* 槽位可写，抢占入队位置 */
+            if (__atomic_compare_exchange_n(&(q->enqueue_pos), &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            /* 槽位尚未被消费，队列满 */
+            return -1;
+        } else {
+            pos = __atomic_load_n(&(q->enqueue_pos), __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->data = data;
+#ifdef QUEUE_STATS
+    QueueStatsPush(q, cell, pos, QueueStatsNow());
+#endif
+    __atomic_store_n(&(cell->sequence), pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+* @brief      无锁队列头部取出元素
+* @note       不阻塞
+* @param[in]  q    队列结构体
+* @param[out] data 数据
+* @return     0    成功
+* @return     -1   队列空
+*/
+int MpmcQueueTryPop(MpmcQueueData* q, void** data)
+{
+    MpmcCell* cell;
+    size_t pos, seq;
+    long dif;
+
+    pos = __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED);
+    for (;;) {
+        cell = &(q->buf[pos & q->mask]);
+        seq = __atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE);
+        dif = (long)seq - (long)(pos + 1);
+        if (dif == 0) {
+            /* 槽位可读，抢占出队位置 */
+            if (__atomic_compare_exchange_n(&(q->dequeue_pos), &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            /* 槽位尚未写入，队列空 */
+            return -1;
+        } else {
+            pos = __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED);
+        }
+    }
+
+    *data = cell->data;
+#ifdef QUEUE_STATS
+    QueueStatsPop(q, cell, QueueStatsNow());
+#endif
+    __atomic_store_n(&(cell->sequence), pos + q->mask + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+* @brief      无锁队列批量插入
+* @note       不阻塞，一次CAS占用连续槽位
+* @param[in]  q     队列结构体
+* @param[in]  items 数据数组
+* @param[in]  n     数据个数
+* @return     实际插入个数
+*/
+int MpmcQueueTryPushBatch(MpmcQueueData* q, void** items, int n)
+{
+    MpmcCell* cell;
+    size_t pos, seq;
+    long dif;
+    int k, i;
+#ifdef QUEUE_STATS
+    uint64_t now;
+#endif
+
+    if (n <= 0) {
+        return 0;
+    }
+
+    pos = __atomic_load_n(&(q->enqueue_pos), __ATOMIC_RELAXED);
+    for (;;) {
+        /* 统计从pos开始连续可写的槽位 */
+        dif = 0;
+        for (k = 0; k < n; k++) {
+            cell = &(q->buf[(pos + k) & q->mask]);
+            seq = __atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE);
+            dif = (long)seq - (long)(pos + k);
+            if (dif != 0) {
+                break;
+            }
+        }
+        if (k == 0) {
+            if (dif < 0) {
+                return 0;
+            }
+            pos = __atomic_load_n(&(q->enqueue_pos), __ATOMIC_RELAXED);
+            continue;
+        }
+        /* 入队位置未变则这k个槽位只属于本线程 */
+        if (__atomic_compare_exchange_n(&(q->enqueue_pos), &pos, pos + k, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+#ifdef QUEUE_STATS
+    now = QueueStatsNow();
+#endif
+    for (i = 0; i < k; i++) {
+        cell = &(q->buf[(pos + i) & q->mask]);
+        cell->data = items[i];
+#ifdef QUEUE_STATS
+        QueueStatsPush(q, cell, pos + i, now);
+#endif
+        __atomic_store_n(&(cell->sequence), pos + i + 1, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+/*
+* @brief      无锁队列批量取出
+* @note       不阻塞，一次CAS占用连续槽位
+* @param[in]  q     队列结构体
+* @param[out] out   数据数组
+* @param[in]  max   最多取出个数
+* @return     实际取出个数
+*/
+int MpmcQueueTryPopBatch(MpmcQueueData* q, void** out, int max)
+{
+    MpmcCell* cell;
+    size_t pos, seq;
+    long dif;
+    int k, i;
+#ifdef QUEUE_STATS
+    uint64_t now;
+#endif
+
+    if (max <= 0) {
+        return 0;
+    }
+
+    pos = __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED);
+    for (;;) {
+        /* 统计从pos开始连续可读的槽位 */
+        dif = 0;
+        for (k = 0; k < max; k++) {
+            cell = &(q->buf[(pos + k) & q->mask]);
+            seq = __atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE);
+            dif = (long)seq - (long)(pos + k + 1);
+            if (dif != 0) {
+                break;
+            }
+        }
+        if (k == 0) {
+            if (dif < 0) {
+                return 0;
+            }
+            pos = __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&(q->dequeue_pos), &pos, pos + k, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+#ifdef QUEUE_STATS
+    now = QueueStatsNow();
+#endif
+    for (i = 0; i < k; i++) {
+        cell = &(q->buf[(pos + i) & q->mask]);
+        out[i] = cell->data;
+#ifdef QUEUE_STATS
+        QueueStatsPop(q, cell, now);
+#endif
+        __atomic_store_n(&(cell->sequence), pos + i + q->mask + 1, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+/*
+* @brief      释放无锁队列
+* @note       
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int MpmcQueueFree(MpmcQueueData* q)
+{
+    if ((q == NULL) || (q->buf == NULL)) {
+        return -1;
+    }
+    free(q->buf);
+    q->buf = NULL;
+    free(q);
+    return 0;
+}
+
+/*
+* @brief      唤醒等待线程
+* @note       全序屏障保证：要么看到等待者并唤醒，要么等待者在挂起前能看到新状态；
+*             只有存在等待者时才加锁
+* @param[in]  mq       队列结构体
+* @param[in]  waiters  等待线程数
+* @param[in]  cond     条件变量
+* @param[in]  count    新增元素或空位个数，大于1时唤醒全部等待者
+* @return     无
+*/
+static void AsyncQueueWake(AsyncQueueData* mq, int* waiters, pthread_cond_t* cond, int count)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiters, __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&(mq->m_mutex));
+        if (count > 1) {
+            pthread_cond_broadcast(cond);
+        } else {
+            pthread_cond_signal(cond);
+        }
+        pthread_mutex_unlock(&(mq->m_mutex));
+    }
+}
+
+/*
+* @brief      计算等待截止时间
+* @note       条件变量使用单调时钟
+* @param[in]  tv   相对超时时间
+* @param[out] ts   截止时间
+* @return     无
+*/
+static void AsyncQueueDeadline(const struct timeval* tv, struct timespec* ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += tv->tv_sec;
+    ts->tv_nsec += tv->tv_usec * 1000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec += ts->tv_nsec / 1000000000;
+        ts->tv_nsec %= 1000000000;
+    }
+}
+
+/*
+* @brief      通知eventfd等待者
+* @note       在AsyncQueueWake之后调用，复用其全序屏障；未登记时只有一次读操作
+* @param[in]  mq   队列结构体
+* @return     无
+*/
+static void AsyncQueueNotify(AsyncQueueData* mq)
+{
+    uint64_t one = 1;
+
+    if (__atomic_load_n(&(mq->event_armed), __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&(mq->event_armed), 0, __ATOMIC_SEQ_CST)) {
+        (void)!write(mq->event_fd, &one, sizeof(one));
+    }
+}
+
+/*
+* @brief      无锁队列是否有已发布的元素
+* @note       并发时为瞬时值
+* @param[in]  q    队列结构体
+* @return     1    非空
+* @return     0    空
+*/
+static int MpmcQueueReadable(MpmcQueueData* q)
+{
+    size_t pos = __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED);
+    MpmcCell* cell = &(q->buf[pos & q->mask]);
+
+    return __atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE) == pos + 1;
+}
+
 /*
 * @brief      条件变量实现异步队列
 * @note       
@@ -129,11 +561,35 @@ int QueueFree(QueueData* q)
 */
 AsyncQueueData* AsyncQueueDataCreate(int size)
 {
-    AsyncQueueData* mq = (AsyncQueueData* )malloc(sizeof(AsyncQueueData));
-    mq->async_queue = QueueCreate(size);
+    pthread_condattr_t attr;
+    AsyncQueueData* mq = NULL;
+
+    /* 按缓存行对齐，等待状态和锁各占缓存行 */
+    if (posix_memalign((void** )&mq, CACHE_LINE_SIZE, sizeof(AsyncQueueData)) != 0) {
+        return NULL;
+    }
+    mq->async_queue = MpmcQueueCreate(size);
+    if (mq->async_queue == NULL) {
+        free(mq);
+        return NULL;
+    }
     mq->wait_pthread = 0;
+    mq->wait_push_pthread = 0;
+    mq->event_fd = -1;
+    mq->event_armed = 0;
+#ifdef QUEUE_STATS
+    mq->push_blocked = 0;
+    mq->push_blocked_ns = 0;
+    mq->pop_waited = 0;
+    mq->pop_wait_ns = 0;
+#endif
     pthread_mutex_init(&(mq->m_mutex), NULL);
-    pthread_cond_init(&(mq->m_cond), NULL);
+    /* 超时等待按单调时钟计算 */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(mq->m_cond), &attr);
+    pthread_cond_init(&(mq->m_full_cond), &attr);
+    pthread_condattr_destroy(&attr);
 
     return mq;
 }
@@ -141,7 +597,7 @@ AsyncQueueData* AsyncQueueDataCreate(int size)
 
 /*
 * @brief      环形队列尾部插入元素
-* @note       
+* @note       队列满时阻塞等待
 * @param[in]  mq    队列结构体
 * @param[in]  data 数据
 * @return     0    成功
@@ -149,49 +605,318 @@ AsyncQueueData* AsyncQueueDataCreate(int size)
 */
 int AsyncQueuePushTail(AsyncQueueData* mq, void* data)
 {
-    /* int ret = pthread_mutex_trylock(&(mq->m_mutex)); */
-
     if (mq == NULL) {
         return -1;
     }
 
-    if (!QueueIsFull(mq->async_queue)) {
-        QueuePushTail(mq->async_queue, data);
-        if (mq->wait_pthread > 0) { 
-            pthread_cond_signal(&(mq->m_cond));       
+    if (MpmcQueueTryPush(mq->async_queue, data) != 0) {
+#ifdef QUEUE_STATS
+        uint64_t start = QueueStatsNow();
+#endif
+        /* 队列满等待 */
+        pthread_mutex_lock(&(mq->m_mutex));
+        __atomic_add_fetch(&(mq->wait_push_pthread), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while (MpmcQueueTryPush(mq->async_queue, data) != 0) {
+            pthread_cond_wait(&(mq->m_full_cond), &(mq->m_mutex));
         }
-    } 
-    pthread_mutex_unlock(&(mq->m_mutex));
-    usleep(1);
+        __atomic_sub_fetch(&(mq->wait_push_pthread), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(mq->m_mutex));
+#ifdef QUEUE_STATS
+        QueueStatsWaited(&(mq->push_blocked), &(mq->push_blocked_ns), start);
+#endif
+    }
+
+    AsyncQueueWake(mq, &(mq->wait_pthread), &(mq->m_cond), 1);
+    AsyncQueueNotify(mq);
     return 0;
 }
 
 /*
 * @brief      环形队列头部取出元素
-* @note       
+* @note       队列空时阻塞等待，超时按单调时钟计算
 * @param[in]  q    队列结构体
-* @param[in]  tv   时间参数
-* @return     void 数据指针
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
 */
 void* AsyncQueuePopHead(AsyncQueueData* mq, struct timeval* tv)
 {
-    /* int ret = pthread_mutex_trylock(&(mq->m_mutex)); */
-
+    struct timespec ts;
     void *retval = NULL;
-    /* 头部为空等待 */
-    if (QueueIsEmpty(mq->async_queue)) {
-        mq->wait_pthread++;
-        while (QueueIsEmpty(mq->async_queue)) {
-            pthread_cond_wait(&(mq->m_cond), &(mq->m_mutex));
+    int timeout = 0;
+
+    if (mq == NULL) {
+        return NULL;
+    }
+
+    if (MpmcQueueTryPop(mq->async_queue, &retval) != 0) {
+        if (tv != NULL && tv->tv_sec == 0 && tv->tv_usec == 0) {
+            return NULL;
+        }
+        if (tv != NULL) {
+            AsyncQueueDeadline(tv, &ts);
+        }
+#ifdef QUEUE_STATS
+        uint64_t start = QueueStatsNow();
+#endif
+
+        /* 头部为空等待 */
+        pthread_mutex_lock(&(mq->m_mutex));
+        __atomic_add_fetch(&(mq->wait_pthread), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while (MpmcQueueTryPop(mq->async_queue, &retval) != 0) {
+            if (tv == NULL) {
+                pthread_cond_wait(&(mq->m_cond), &(mq->m_mutex));
+            } else if (pthread_cond_timedwait(&(mq->m_cond), &(mq->m_mutex), &ts) == ETIMEDOUT) {
+                timeout = MpmcQueueTryPop(mq->async_queue, &retval) != 0;
+                break;
+            }
+        }
+        __atomic_sub_fetch(&(mq->wait_pthread), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(mq->m_mutex));
+#ifdef QUEUE_STATS
+        QueueStatsWaited(&(mq->pop_waited), &(mq->pop_wait_ns), start);
+#endif
+        if (timeout) {
+            return NULL;
         }
-        mq->wait_pthread--;
     }
-    retval = QueuePopHead(mq->async_queue);
-    pthread_mutex_unlock(&(mq->m_mutex));
-    usleep(1);
+
+    AsyncQueueWake(mq, &(mq->wait_push_pthread), &(mq->m_full_cond), 1);
+    return retval;
+}
+
+/*
+* @brief      环形队列头部取出元素，不阻塞
+* @note       
+* @param[in]  mq   队列结构体
+* @return     void 数据指针，队列空返回NULL
+*/
+void* AsyncQueueTryPop(AsyncQueueData* mq)
+{
+    void *retval = NULL;
+
+    if (mq == NULL || MpmcQueueTryPop(mq->async_queue, &retval) != 0) {
+        return NULL;
+    }
+
+    AsyncQueueWake(mq, &(mq->wait_push_pthread), &(mq->m_full_cond), 1);
     return retval;
 }
 
+/*
+* @brief      获取队列就绪通知fd
+* @note       首次调用时创建eventfd，可加入epoll等待可读；队列释放时关闭
+* @param[in]  mq   队列结构体
+* @return     fd
+* @return     -1   失败
+*/
+int AsyncQueueGetEventFd(AsyncQueueData* mq)
+{
+    int fd;
+
+    if (mq == NULL) {
+        return -1;
+    }
+
+    fd = __atomic_load_n(&(mq->event_fd), __ATOMIC_ACQUIRE);
+    if (fd >= 0) {
+        return fd;
+    }
+    pthread_mutex_lock(&(mq->m_mutex));
+    if (mq->event_fd < 0) {
+        __atomic_store_n(&(mq->event_fd), eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), __ATOMIC_RELEASE);
+    }
+    fd = mq->event_fd;
+    pthread_mutex_unlock(&(mq->m_mutex));
+    return fd;
+}
+
+/*
+* @brief      登记等待就绪通知
+* @note       先清空计数再登记，登记后复查队列：
+*             生产者要么看到登记并写fd，要么消费者复查时看到数据；
+*             复查非空时重新写fd，保证同一fd上的其他等待者不会漏掉通知
+* @param[in]  mq   队列结构体
+* @return     0    已登记，队列为空
+* @return     1    队列非空
+* @return     -1   失败
+*/
+int AsyncQueueEventArm(AsyncQueueData* mq)
+{
+    uint64_t value = 1;
+    int fd = AsyncQueueGetEventFd(mq);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    (void)!read(fd, &value, sizeof(value));
+    __atomic_store_n(&(mq->event_armed), 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!MpmcQueueReadable(mq->async_queue)) {
+        return 0;
+    }
+
+    value = 1;
+    (void)!write(fd, &value, sizeof(value));
+    return 1;
+}
+
+/*
+* @brief      批量插入元素
+* @note       队列满时阻塞直到全部插入，每批只唤醒一次消费者
+* @param[in]  mq    队列结构体
+* @param[in]  items 数据数组
+* @param[in]  n     数据个数
+* @return     插入个数
+* @return     -1    失败
+*/
+int AsyncQueuePushBatch(AsyncQueueData* mq, void** items, int n)
+{
+    int done, pushed;
+
+    if (mq == NULL || items == NULL || n < 0) {
+        return -1;
+    }
+
+    done = MpmcQueueTryPushBatch(mq->async_queue, items, n);
+    if (done < n) {
+        /* 剩余部分先唤醒已到的消费者腾出空间，再等待 */
+        if (done > 0) {
+            AsyncQueueWake(mq, &(mq->wait_pthread), &(mq->m_cond), done);
+            AsyncQueueNotify(mq);
+        }
+#ifdef QUEUE_STATS
+        uint64_t start = QueueStatsNow();
+#endif
+        pthread_mutex_lock(&(mq->m_mutex));
+        __atomic_add_fetch(&(mq->wait_push_pthread), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while (done < n) {
+            pushed = MpmcQueueTryPushBatch(mq->async_queue, items + done, n - done);
+            if (pushed == 0) {
+                pthread_cond_wait(&(mq->m_full_cond), &(mq->m_mutex));
+                continue;
+            }
+            done += pushed;
+            /* 持锁期间消费者无法挂起，唤醒直接发出 */
+            if (__atomic_load_n(&(mq->wait_pthread), __ATOMIC_RELAXED) > 0) {
+                pthread_cond_broadcast(&(mq->m_cond));
+            }
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            AsyncQueueNotify(mq);
+        }
+        __atomic_sub_fetch(&(mq->wait_push_pthread), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(mq->m_mutex));
+#ifdef QUEUE_STATS
+        QueueStatsWaited(&(mq->push_blocked), &(mq->push_blocked_ns), start);
+#endif
+        return n;
+    }
+
+    AsyncQueueWake(mq, &(mq->wait_pthread), &(mq->m_cond), n);
+    AsyncQueueNotify(mq);
+    return n;
+}
+
+/*
+* @brief      批量取出元素
+* @note       队列空时等待，取到至少一个元素后返回
+* @param[in]  mq    队列结构体
+* @param[out] out   数据数组
+* @param[in]  max   最多取出个数
+* @param[in]  tv    超时时间，NULL一直等待，0不等待
+* @return     取出个数，超时返回0
+* @return     -1    失败
+*/
+int AsyncQueuePopBatch(AsyncQueueData* mq, void** out, int max, struct timeval* tv)
+{
+    struct timespec ts;
+    int count;
+
+    if (mq == NULL || out == NULL || max <= 0) {
+        return -1;
+    }
+
+    count = MpmcQueueTryPopBatch(mq->async_queue, out, max);
+    if (count == 0) {
+        if (tv != NULL && tv->tv_sec == 0 && tv->tv_usec == 0) {
+            return 0;
+        }
+        if (tv != NULL) {
+            AsyncQueueDeadline(tv, &ts);
+        }
+#ifdef QUEUE_STATS
+        uint64_t start = QueueStatsNow();
+#endif
+
+        /* 头部为空等待 */
+        pthread_mutex_lock(&(mq->m_mutex));
+        __atomic_add_fetch(&(mq->wait_pthread), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        while ((count = MpmcQueueTryPopBatch(mq->async_queue, out, max)) == 0) {
+            if (tv == NULL) {
+                pthread_cond_wait(&(mq->m_cond), &(mq->m_mutex));
+            } else if (pthread_cond_timedwait(&(mq->m_cond), &(mq->m_mutex), &ts) == ETIMEDOUT) {
+                count = MpmcQueueTryPopBatch(mq->async_queue, out, max);
+                break;
+            }
+        }
+        __atomic_sub_fetch(&(mq->wait_pthread), 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&(mq->m_mutex));
+#ifdef QUEUE_STATS
+        QueueStatsWaited(&(mq->pop_waited), &(mq->pop_wait_ns), start);
+#endif
+    }
+
+    if (count > 0) {
+        AsyncQueueWake(mq, &(mq->wait_push_pthread), &(mq->m_full_cond), count);
+    }
+    return count;
+}
+
+/*
+* @brief      获取队列统计
+* @note       未定义QUEUE_STATS时只填写插入取出总数和当前深度
+* @param[in]  mq    队列结构体
+* @param[out] stats 统计结果
+* @return     0    成功
+* @return     -1   失败或未启用统计
+*/
+int AsyncQueueGetStats(AsyncQueueData* mq, AsyncQueueStats* stats)
+{
+    MpmcQueueData* q;
+    size_t dequeue_pos;
+
+    if (mq == NULL || stats == NULL) {
+        return -1;
+    }
+    memset(stats, 0, sizeof(AsyncQueueStats));
+    q = mq->async_queue;
+    dequeue_pos = __atomic_load_n(&(q->dequeue_pos), __ATOMIC_RELAXED);
+    stats->pushed = __atomic_load_n(&(q->enqueue_pos), __ATOMIC_RELAXED);
+    stats->popped = dequeue_pos;
+    stats->depth = (long)(stats->pushed - dequeue_pos) > 0 ? (int)(stats->pushed - dequeue_pos) : 0;
+
+#ifdef QUEUE_STATS
+    int i;
+
+    stats->peak_depth = (int)__atomic_load_n(&(q->peak_depth), __ATOMIC_RELAXED);
+    stats->push_blocked = __atomic_load_n(&(mq->push_blocked), __ATOMIC_RELAXED);
+    stats->push_blocked_ns = __atomic_load_n(&(mq->push_blocked_ns), __ATOMIC_RELAXED);
+    stats->pop_waited = __atomic_load_n(&(mq->pop_waited), __ATOMIC_RELAXED);
+    stats->pop_wait_ns = __atomic_load_n(&(mq->pop_wait_ns), __ATOMIC_RELAXED);
+    stats->sojourn_max_ns = __atomic_load_n(&(q->sojourn_max_ns), __ATOMIC_RELAXED);
+    for (i = 0; i < QUEUE_STATS_BUCKETS; i++) {
+        stats->sojourn_hist[i] = __atomic_load_n(&(q->sojourn_hist[i]), __ATOMIC_RELAXED);
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
 /*
 * @brief      释放环形队列
 * @note       
@@ -204,10 +929,14 @@ int AsyncQueueFree(AsyncQueueData* mq)
     if (mq == NULL) {
         return -1;
     }
-    QueueFree(mq->async_queue);
+    MpmcQueueFree(mq->async_queue);
+    if (mq->event_fd >= 0) {
+        close(mq->event_fd);
+    }
     pthread_mutex_destroy(&(mq->m_mutex));
     pthread_cond_destroy(&(mq->m_cond));
+    pthread_cond_destroy(&(mq->m_full_cond));
     free(mq);
     mq = NULL;
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
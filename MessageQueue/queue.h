@@ -15,38 +15,118 @@
 #ifndef __LOCK_H__INCLUDE_
 #define __LOCK_H__INCLUDE_
 
-#pragma pack(1)
-
 #include <pthread.h>
 #include <semaphore.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE     64          /* 缓存行大小 */
+#endif
+
+/*
+* 定义QUEUE_STATS时统计队列深度、逗留时间和等待时间，结构体布局随之变化，
+* 使用队列的所有源文件需要统一定义；未定义时没有任何额外开销
+*/
+#define QUEUE_STATS_BUCKETS 40          /* 逗留时间直方图桶数，第i桶为[2^i, 2^(i+1))纳秒 */
+
 /*
 * @brief      队列数据结构体
+* @note       头部由取出方写、尾部由插入方写，各占一个缓存行；
+*             头尾为不回绕的计数，元素个数为二者之差
 */
 typedef struct Queue{
-    int     header;             /* 头部 */                        
-    int     tail;               /* 尾部 */
-    int     size;               /* 队列长度 */
-    int     capcity;            /* 容量 */
-    void**  buf;                /* 数据 */
+    void**          buf;        /* 数据 */
+    unsigned int    capcity;    /* 容量，2的幂 */
+    char            pad0[CACHE_LINE_SIZE - sizeof(void**) - sizeof(unsigned int)];
+    unsigned int    header;     /* 头部 */
+    char            pad1[CACHE_LINE_SIZE - sizeof(unsigned int)];
+    unsigned int    tail;       /* 尾部 */
+    char            pad2[CACHE_LINE_SIZE - sizeof(unsigned int)];
 }QueueData;
 
+/*
+* @brief      无锁队列槽位
+*/
+typedef struct MpmcCell{
+    size_t  sequence;           /* 槽位序号，决定槽位可写或可读 */
+    void*   data;               /* 数据 */
+#ifdef QUEUE_STATS
+    uint64_t stamp;             /* 入队时间，纳秒 */
+#endif
+}MpmcCell;
+
+/*
+* @brief      无锁多生产者多消费者有界队列
+* @note       槽位序号法(Vyukov)，入队和出队位置各占一个缓存行
+*/
+typedef struct MpmcQueue{
+    MpmcCell*   buf;                                            /* 槽位数组 */
+    size_t      mask;                                           /* 容量减一，容量为2的幂 */
+    char        pad0[CACHE_LINE_SIZE - sizeof(MpmcCell*) - sizeof(size_t)];
+    size_t      enqueue_pos;                                    /* 入队位置 */
+    char        pad1[CACHE_LINE_SIZE - sizeof(size_t)];
+    size_t      dequeue_pos;                                    /* 出队位置 */
+    char        pad2[CACHE_LINE_SIZE - sizeof(size_t)];
+#ifdef QUEUE_STATS
+    uint64_t    peak_depth;                                     /* 峰值深度 */
+    uint64_t    sojourn_max_ns;                                 /* 最长逗留时间 */
+    unsigned long sojourn_hist[QUEUE_STATS_BUCKETS];            /* 逗留时间直方图 */
+#endif
+}MpmcQueueData;
+
+/*
+* @brief      异步队列统计
+* @note       插入和取出总数即无锁队列的入队和出队位置，不额外计数
+*/
+typedef struct AsyncQueueStats{
+    unsigned long   pushed;                     /* 插入总数 */
+    unsigned long   popped;                     /* 取出总数 */
+    int             depth;                      /* 当前深度 */
+    int             peak_depth;                 /* 峰值深度 */
+    unsigned long   push_blocked;               /* 生产者因队列满阻塞次数 */
+    uint64_t        push_blocked_ns;            /* 生产者阻塞总时长 */
+    unsigned long   pop_waited;                 /* 消费者因队列空等待次数 */
+    uint64_t        pop_wait_ns;                /* 消费者等待总时长 */
+    uint64_t        sojourn_max_ns;             /* 最长逗留时间 */
+    unsigned long   sojourn_hist[QUEUE_STATS_BUCKETS];  /* 逗留时间直方图 */
+}AsyncQueueStats;
+
 /*
 * @brief      异步队列数据结构体
+* @note       数据收发走无锁队列，互斥锁和条件变量只在队列空或满需要等待时使用
 */
 typedef struct AsyncQueue{
-    pthread_mutex_t     m_mutex;                /* 线程互斥锁 */
-    pthread_cond_t      m_cond;                 /* 线程条件变量 */
-    int                 wait_pthread;           /* 等待线程数量 */
-    QueueData*          async_queue;            /* 队列数据 */
+    /* 只读字段，所有线程共享 */
+    MpmcQueueData*      async_queue;            /* 队列数据 */
+    int                 event_fd;               /* 就绪通知eventfd，未使用时为-1 */
+    /* 取出方等待状态，插入方每次插入都读取，只在等待时写 */
+    int                 wait_pthread __attribute__((aligned(CACHE_LINE_SIZE)));  /* 等待取出的线程数量 */
+    int                 event_armed;            /* 消费者已登记等待eventfd */
+    /* 插入方等待状态，取出方每次取出都读取，只在等待时写 */
+    int                 wait_push_pthread __attribute__((aligned(CACHE_LINE_SIZE)));  /* 等待放入的线程数量 */
+    /* 慢路径，只在队列空或满时使用 */
+    pthread_mutex_t     m_mutex __attribute__((aligned(CACHE_LINE_SIZE)));  /* 线程互斥锁 */
+    pthread_cond_t      m_cond;                 /* 非空条件变量 */
+    pthread_cond_t      m_full_cond;            /* 非满条件变量 */
+#ifdef QUEUE_STATS
+    unsigned long       push_blocked __attribute__((aligned(CACHE_LINE_SIZE)));  /* 生产者阻塞次数 */
+    uint64_t            push_blocked_ns;        /* 生产者阻塞总时长 */
+    unsigned long       pop_waited;             /* 消费者等待次数 */
+    uint64_t            pop_wait_ns;            /* 消费者等待总时长 */
+#endif
 }AsyncQueueData;
 
 /*
 * @brief      环形队列创建
-* @note       
+* @note       容量向上取整为2的幂
 * @param[in]  size    队列长度
 * @return     队列指针
 * @retval     无
@@ -77,7 +157,7 @@ int QueueIsEmpty(QueueData* );
 * @param[in]  q    队列结构体
 * @param[in]  data 数据
 * @return     0    成功
-* @return     -1   失败
+* @return     -1   失败，队列满
 */
 int QueuePushTail(QueueData* , void* );
 
@@ -98,6 +178,63 @@ void* QueuePopHead(QueueData* );
 */
 int QueueFree(QueueData* );
 
+/*
+* @brief      无锁队列创建
+* @note       容量向上取整为2的幂
+* @param[in]  size    队列长度
+* @return     队列指针
+*/
+MpmcQueueData* MpmcQueueCreate(int );
+
+/*
+* @brief      无锁队列尾部插入元素
+* @note       不阻塞
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     -1   队列满
+*/
+int MpmcQueueTryPush(MpmcQueueData* , void* );
+
+/*
+* @brief      无锁队列头部取出元素
+* @note       不阻塞
+* @param[in]  q    队列结构体
+* @param[out] data 数据
+* @return     0    成功
+* @return     -1   队列空
+*/
+int MpmcQueueTryPop(MpmcQueueData* , void** );
+
+/*
+* @brief      无锁队列批量插入
+* @note       不阻塞，一次CAS占用连续槽位
+* @param[in]  q     队列结构体
+* @param[in]  items 数据数组
+* @param[in]  n     数据个数
+* @return     实际插入个数
+*/
+int MpmcQueueTryPushBatch(MpmcQueueData* , void** , int );
+
+/*
+* @brief      无锁队列批量取出
+* @note       不阻塞，一次CAS占用连续槽位
+* @param[in]  q     队列结构体
+* @param[out] out   数据数组
+* @param[in]  max   最多取出个数
+* @return     实际取出个数
+*/
+int MpmcQueueTryPopBatch(MpmcQueueData* , void** , int );
+
+/*
+* @brief      释放无锁队列
+* @note       
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int MpmcQueueFree(MpmcQueueData* );
+
 /*
 * @brief      条件变量实现异步队列
 * @note       
@@ -108,7 +245,7 @@ AsyncQueueData* AsyncQueueDataCreate(int );
 
 /*
 * @brief      环形队列尾部插入元素
-* @note       
+* @note       队列满时阻塞等待
 * @param[in]  mq    队列结构体
 * @param[in]  data 数据
 * @return     0    成功
@@ -118,13 +255,74 @@ int AsyncQueuePushTail(AsyncQueueData* , void* );
 
 /*
 * @brief      环形队列头部取出元素
-* @note       
+* @note       队列空时阻塞等待，超时按单调时钟计算
 * @param[in]  q    队列结构体
-* @param[in]  tv   时间参数
-* @return     void 数据指针
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
 */
 void* AsyncQueuePopHead(AsyncQueueData* , struct timeval* );
 
+/*
+* @brief      环形队列头部取出元素，不阻塞
+* @note       
+* @param[in]  mq   队列结构体
+* @return     void 数据指针，队列空返回NULL
+*/
+void* AsyncQueueTryPop(AsyncQueueData* );
+
+/*
+* @brief      获取队列就绪通知fd
+* @note       首次调用时创建eventfd，可加入epoll等待可读；队列释放时关闭
+* @param[in]  mq   队列结构体
+* @return     fd
+* @return     -1   失败
+*/
+int AsyncQueueGetEventFd(AsyncQueueData* );
+
+/*
+* @brief      登记等待就绪通知
+* @note       取空队列后、进入epoll_wait前调用；返回0时下一次插入会使fd可读，
+*             返回1时队列已有数据，fd保持可读，应直接再次取出
+* @param[in]  mq   队列结构体
+* @return     0    已登记，队列为空
+* @return     1    队列非空
+* @return     -1   失败
+*/
+int AsyncQueueEventArm(AsyncQueueData* );
+
+/*
+* @brief      批量插入元素
+* @note       队列满时阻塞直到全部插入，每批只唤醒一次消费者
+* @param[in]  mq    队列结构体
+* @param[in]  items 数据数组
+* @param[in]  n     数据个数
+* @return     插入个数
+* @return     -1    失败
+*/
+int AsyncQueuePushBatch(AsyncQueueData* , void** , int );
+
+/*
+* @brief      批量取出元素
+* @note       队列空时等待，取到至少一个元素后返回
+* @param[in]  mq    队列结构体
+* @param[out] out   数据数组
+* @param[in]  max   最多取出个数
+* @param[in]  tv    超时时间，NULL一直等待，0不等待
+* @return     取出个数，超时返回0
+* @return     -1    失败
+*/
+int AsyncQueuePopBatch(AsyncQueueData* , void** , int , struct timeval* );
+
+/*
+* @brief      获取队列统计
+* @note       未定义QUEUE_STATS时只填写插入取出总数和当前深度
+* @param[in]  mq    队列结构体
+* @param[out] stats 统计结果
+* @return     0    成功
+* @return     -1   失败或未启用统计
+*/
+int AsyncQueueGetStats(AsyncQueueData* , AsyncQueueStats* );
+
 /*
 * @brief      释放环形队列
 * @note       
@@ -134,4 +332,8 @@ void* AsyncQueuePopHead(AsyncQueueData* , struct timeval* );
 */
 int AsyncQueueFree(AsyncQueueData* );
 
-#endif
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,335 @@
+/**
+* @file      segQueue.c
+* @brief     无界分段队列源文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include <errno.h>
+#include <time.h>
+#include "segQueue.h"
+
+/*
+* @brief      获取空闲分段
+* @note       优先从分段池取，池空时才分配；调用者持有锁
+* @param[in]  q    队列结构体
+* @return     分段指针，失败返回NULL
+*/
+static SegQueueSegment* SegQueueGetSegment(SegQueueData* q)
+{
+    SegQueueSegment* seg = q->free_seg;
+
+    if (seg != NULL) {
+        q->free_seg = seg->next;
+        q->free_number--;
+    } else {
+        seg = (SegQueueSegment* )malloc(sizeof(SegQueueSegment) + q->seg_size * sizeof(void* ));
+        if (seg == NULL) {
+            return NULL;
+        }
+    }
+    seg->next = NULL;
+    seg->head = seg->tail = 0;
+    return seg;
+}
+
+/*
+* @brief      回收分段
+* @note       分段池未满时放回池中，否则释放；调用者持有锁
+* @param[in]  q    队列结构体
+* @param[in]  seg  分段
+* @return     无
+*/
+static void SegQueuePutSegment(SegQueueData* q, SegQueueSegment* seg)
+{
+    if (q->free_number < q->pool_size) {
+        seg->next = q->free_seg;
+        q->free_seg = seg;
+        q->free_number++;
+    } else {
+        free(seg);
+    }
+}
+
+/*
+* @brief      释放分段链表
+* @note
+* @param[in]  seg  链表头
+* @return     无
+*/
+static void SegQueueFreeList(SegQueueSegment* seg)
+{
+    SegQueueSegment* next;
+
+    while (seg != NULL) {
+        next = seg->next;
+        free(seg);
+        seg = next;
+    }
+}
+
+/*
+* @brief      取出一个元素
+* @note       调用者持有锁且队列非空
+* @param[in]  q    队列结构体
+* @return     void 数据指针
+*/
+static void* SegQueueTake(SegQueueData* q)
+{
+    SegQueueSegment* seg = q->head_seg;
+    void* data;
+
+    /* 读完的分段回收，非空队列中读完的分段后面必有下一个分段 */
+    if (seg->head == q->seg_size) {
+        q->head_seg = seg->next;
+        SegQueuePutSegment(q, seg);
+        seg = q->head_seg;
+    }
+    data = seg->buf[seg->head++];
+    q->size--;
+
+    /* 队列空时只剩一个分段，从头复用 */
+    if (q->size == 0) {
+        seg->head = seg->tail = 0;
+    }
+    if (q->above_high && q->size <= q->high_water / 2) {
+        q->above_high = 0;
+    }
+    return data;
+}
+
+/*
+* @brief      无界分段队列创建
+* @note       创建时预分配分段池，分段池内的分段复用不释放
+* @param[in]  seg_size   分段长度，小于等于0使用默认值
+* @param[in]  pool_size  分段池保留的空闲分段数，小于0使用默认值
+* @return     队列指针
+*/
+SegQueueData* SegQueueCreate(int seg_size, int pool_size)
+{
+    pthread_condattr_t attr;
+    SegQueueSegment* seg;
+    SegQueueData* q;
+    int i;
+
+    q = (SegQueueData* )malloc(sizeof(SegQueueData));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->seg_size = seg_size > 0 ? seg_size : SEG_QUEUE_SEGMENT_SIZE;
+    q->pool_size = pool_size >= 0 ? pool_size : SEG_QUEUE_POOL_SIZE;
+    q->free_seg = NULL;
+    q->free_number = 0;
+    q->size = 0;
+    q->wait_pthread = 0;
+    q->high_water = 0;
+    q->above_high = 0;
+    q->high_water_func = NULL;
+    q->high_water_arg = NULL;
+
+    q->head_seg = q->tail_seg = SegQueueGetSegment(q);
+    if (q->head_seg == NULL) {
+        free(q);
+        return NULL;
+    }
+    for (i = 0; i < q->pool_size; i++) {
+        seg = (SegQueueSegment* )malloc(sizeof(SegQueueSegment) + q->seg_size * sizeof(void* ));
+        if (seg == NULL) {
+            break;
+        }
+        SegQueuePutSegment(q, seg);
+    }
+
+    pthread_mutex_init(&(q->m_mutex), NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&(q->m_cond), &attr);
+    pthread_condattr_destroy(&attr);
+    return q;
+}
+
+/*
+* @brief      设置高水位
+* @note       元素个数达到mark时push返回1并调用回调，回调在锁外执行
+* @param[in]  q     队列结构体
+* @param[in]  mark  高水位，0表示关闭
+* @param[in]  func  回调函数，可为NULL
+* @param[in]  arg   回调参数
+* @return     0    成功
+* @return     -1   失败
+*/
+int SegQueueSetHighWater(SegQueueData* q, int mark, void (*func)(void* , int ), void* arg)
+{
+    if (q == NULL || mark < 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&(q->m_mutex));
+    q->high_water = mark;
+    q->above_high = 0;
+    q->high_water_func = func;
+    q->high_water_arg = arg;
+    pthread_mutex_unlock(&(q->m_mutex));
+    return 0;
+}
+
+/*
+* @brief      尾部插入元素
+* @note       不会因队列满丢弃数据
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     1    成功，且本次插入达到高水位
+* @return     -1   失败，分段内存不足
+*/
+int SegQueuePushTail(SegQueueData* q, void* data)
+{
+    SegQueueSegment* seg;
+    void (*func)(void* , int ) = NULL;
+    void* arg = NULL;
+    int size, ret = 0;
+
+    if (q == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&(q->m_mutex));
+    seg = q->tail_seg;
+    if (seg->tail == q->seg_size) {
+        seg = SegQueueGetSegment(q);
+        if (seg == NULL) {
+            pthread_mutex_unlock(&(q->m_mutex));
+            return -1;
+        }
+        q->tail_seg->next = seg;
+        q->tail_seg = seg;
+    }
+    seg->buf[seg->tail++] = data;
+    size = ++q->size;
+
+    if (q->high_water > 0 && !q->above_high && size >= q->high_water) {
+        q->above_high = 1;
+        func = q->high_water_func;
+        arg = q->high_water_arg;
+        ret = 1;
+    }
+    if (q->wait_pthread > 0) {
+        pthread_cond_signal(&(q->m_cond));
+    }
+    pthread_mutex_unlock(&(q->m_mutex));
+
+    if (func != NULL) {
+        func(arg, size);
+    }
+    return ret;
+}
+
+/*
+* @brief      头部取出元素
+* @note       队列空时阻塞等待，超时按单调时钟计算
+* @param[in]  q    队列结构体
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
+*/
+void* SegQueuePopHead(SegQueueData* q, struct timeval* tv)
+{
+    struct timespec ts;
+    void* data = NULL;
+
+    if (q == NULL) {
+        return NULL;
+    }
+
+    if (tv != NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec += tv->tv_sec;
+        ts.tv_nsec += tv->tv_usec * 1000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec += ts.tv_nsec / 1000000000;
+            ts.tv_nsec %= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&(q->m_mutex));
+    q->wait_pthread++;
+    while (q->size == 0) {
+        if (tv == NULL) {
+            pthread_cond_wait(&(q->m_cond), &(q->m_mutex));
+        } else if ((tv->tv_sec == 0 && tv->tv_usec == 0) ||
+                   pthread_cond_timedwait(&(q->m_cond), &(q->m_mutex), &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    q->wait_pthread--;
+    if (q->size > 0) {
+        data = SegQueueTake(q);
+    }
+    pthread_mutex_unlock(&(q->m_mutex));
+    return data;
+}
+
+/*
+* @brief      头部取出元素，不阻塞
+* @note
+* @param[in]  q    队列结构体
+* @return     void 数据指针，队列空返回NULL
+*/
+void* SegQueueTryPop(SegQueueData* q)
+{
+    void* data = NULL;
+
+    if (q == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&(q->m_mutex));
+    if (q->size > 0) {
+        data = SegQueueTake(q);
+    }
+    pthread_mutex_unlock(&(q->m_mutex));
+    return data;
+}
+
+/*
+* @brief      队列元素个数
+* @note
+* @param[in]  q    队列结构体
+* @return     元素个数
+*/
+int SegQueueSize(SegQueueData* q)
+{
+    int size;
+
+    if (q == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&(q->m_mutex));
+    size = q->size;
+    pthread_mutex_unlock(&(q->m_mutex));
+    return size;
+}
+
+/*
+* @brief      释放队列
+* @note       队列中剩余的数据指针不释放
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int SegQueueFree(SegQueueData* q)
+{
+    if (q == NULL) {
+        return -1;
+    }
+    SegQueueFreeList(q->head_seg);
+    SegQueueFreeList(q->free_seg);
+    pthread_mutex_destroy(&(q->m_mutex));
+    pthread_cond_destroy(&(q->m_cond));
+    free(q);
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+* @file      segQueue.h
+* @brief     无界分段队列头文件
+*
+* 由定长分段链接而成，分段用完后回收到分段池复用，稳态下不分配内存
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#ifndef __SEG_QUEUE_H__INCLUDE_
+#define __SEG_QUEUE_H__INCLUDE_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEG_QUEUE_SEGMENT_SIZE  256     /* 默认分段长度 */
+#define SEG_QUEUE_POOL_SIZE     16      /* 默认分段池保留的空闲分段数 */
+
+/*
+* @brief      队列分段
+*/
+typedef struct SegQueueSegment{
+    struct SegQueueSegment* next;       /* 下一个分段 */
+    int                     head;       /* 分段内读位置 */
+    int                     tail;       /* 分段内写位置 */
+    void*                   buf[];      /* 数据 */
+}SegQueueSegment;
+
+/*
+* @brief      无界分段队列
+* @note       元素个数超过高水位时回调一次，回落到高水位一半以下后重新生效
+*/
+typedef struct SegQueue{
+    pthread_mutex_t     m_mutex;                /* 线程互斥锁 */
+    pthread_cond_t      m_cond;                 /* 非空条件变量 */
+    int                 wait_pthread;           /* 等待取出的线程数量 */
+    SegQueueSegment*    head_seg;               /* 读分段 */
+    SegQueueSegment*    tail_seg;               /* 写分段 */
+    SegQueueSegment*    free_seg;               /* 分段池 */
+    int                 free_number;            /* 分段池中的分段数 */
+    int                 pool_size;              /* 分段池最多保留的分段数 */
+    int                 seg_size;               /* 分段长度 */
+    int                 size;                   /* 元素个数 */
+    int                 high_water;             /* 高水位，0表示不检查 */
+    int                 above_high;             /* 已超过高水位 */
+    void (*high_water_func)(void* , int );      /* 高水位回调，参数为用户参数和当前元素个数 */
+    void*               high_water_arg;         /* 高水位回调参数 */
+}SegQueueData;
+
+/*
+* @brief      无界分段队列创建
+* @note       创建时预分配分段池，分段池内的分段复用不释放
+* @param[in]  seg_size   分段长度，小于等于0使用默认值
+* @param[in]  pool_size  分段池保留的空闲分段数，小于0使用默认值
+* @return     队列指针
+*/
+SegQueueData* SegQueueCreate(int , int );
+
+/*
+* @brief      设置高水位
+* @note       元素个数达到mark时push返回1并调用回调，回调在锁外执行
+* @param[in]  q     队列结构体
+* @param[in]  mark  高水位，0表示关闭
+* @param[in]  func  回调函数，可为NULL
+* @param[in]  arg   回调参数
+* @return     0    成功
+* @return     -1   失败
+*/
+int SegQueueSetHighWater(SegQueueData* , int , void (*)(void* , int ), void* );
+
+/*
+* @brief      尾部插入元素
+* @note       不会因队列满丢弃数据
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     1    成功，且本次插入达到高水位
+* @return     -1   失败，分段内存不足
+*/
+int SegQueuePushTail(SegQueueData* , void* );
+
+/*
+* @brief      头部取出元素
+* @note       队列空时阻塞等待，超时按单调时钟计算
+* @param[in]  q    队列结构体
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     void 数据指针，超时返回NULL
+*/
+void* SegQueuePopHead(SegQueueData* , struct timeval* );
+
+/*
+* @brief      头部取出元素，不阻塞
+* @note
+* @param[in]  q    队列结构体
+* @return     void 数据指针，队列空返回NULL
+*/
+void* SegQueueTryPop(SegQueueData* );
+
+/*
+* @brief      队列元素个数
+* @note
+* @param[in]  q    队列结构体
+* @return     元素个数
+*/
+int SegQueueSize(SegQueueData* );
+
+/*
+* @brief      释放队列
+* @note       队列中剩余的数据指针不释放
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int SegQueueFree(SegQueueData* );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,492 @@
+/**
+* @file      shmQueue.c
+* @brief     共享内存进程间队列源文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "shmQueue.h"
+
+#define SHM_RECORD_SIZE(len)    (sizeof(ShmRecord) + (((len) + SHM_RECORD_ALIGN - 1) & ~(size_t)(SHM_RECORD_ALIGN - 1)))
+
+/*
+* @brief      计算截止时间
+* @note
+* @param[in]  tv   相对超时时间
+* @param[out] ts   单调时钟截止时间
+* @return     无
+*/
+static void ShmQueueDeadline(const struct timeval* tv, struct timespec* ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += tv->tv_sec;
+    ts->tv_nsec += tv->tv_usec * 1000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec += ts->tv_nsec / 1000000000;
+        ts->tv_nsec %= 1000000000;
+    }
+}
+
+/*
+* @brief      在futex上等待
+* @note       进程共享futex，不能使用FUTEX_PRIVATE_FLAG
+* @param[in]  addr      futex地址
+* @param[in]  val       期望值，不等时立即返回
+* @param[in]  deadline  截止时间，NULL一直等待
+* @return     0         被唤醒或值已改变
+* @return     -1        超时
+*/
+static int ShmFutexWait(uint32_t* addr, uint32_t val, const struct timespec* deadline)
+{
+    struct timespec now, rel, *timeout = NULL;
+
+    if (deadline != NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        rel.tv_sec = deadline->tv_sec - now.tv_sec;
+        rel.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+        if (rel.tv_nsec < 0) {
+            rel.tv_sec--;
+            rel.tv_nsec += 1000000000;
+        }
+        if (rel.tv_sec < 0) {
+            return -1;
+        }
+        timeout = &rel;
+    }
+    if (syscall(SYS_futex, addr, FUTEX_WAIT, val, timeout, NULL, 0) != 0 && errno == ETIMEDOUT) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+* @brief      唤醒futex等待者
+* @note       对方先置等待标志再复查，本方先发布位置再检查标志，全序屏障保证不丢唤醒
+* @param[in]  seq      futex地址
+* @param[in]  waiting  对方等待标志
+* @return     无
+*/
+static void ShmFutexWake(uint32_t* seq, uint32_t* waiting)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(waiting, 0, __ATOMIC_SEQ_CST)) {
+        __atomic_add_fetch(seq, 1, __ATOMIC_SEQ_CST);
+        syscall(SYS_futex, seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+/*
+* @brief      初始化共享内存头部
+* @note       魔数最后写入，其他进程看到魔数即可使用
+* @param[in]  header    共享内存头部
+* @param[in]  capacity  数据区字节数
+* @return     0    成功
+* @return     -1   失败
+*/
+static int ShmQueueInitHeader(ShmQueueHeader* header, size_t capacity)
+{
+    pthread_mutexattr_t attr;
+
+    memset(header, 0, sizeof(ShmQueueHeader));
+    header->version = SHM_QUEUE_VERSION;
+    header->capacity = capacity;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    if (pthread_mutex_init(&(header->producer_lock), &attr) != 0) {
+        pthread_mutexattr_destroy(&attr);
+        return -1;
+    }
+    pthread_mutexattr_destroy(&attr);
+
+    __atomic_store_n(&(header->magic), SHM_QUEUE_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+* @brief      打开共享内存队列
+* @note       create为1且不存在时创建并初始化，已存在时沿用其中的读写位置；
+*             create为0时只打开已初始化的队列
+* @param[in]  name      共享内存名称，以'/'开头
+* @param[in]  capacity  数据区字节数，向上取整为2的幂
+* @param[in]  create    是否创建
+* @return     队列指针，失败返回NULL
+*/
+ShmQueueData* ShmQueueOpen(const char* name, size_t capacity, int create)
+{
+    ShmQueueData* q = NULL;
+    struct stat st;
+    size_t size = SHM_QUEUE_MIN_SIZE;
+    int fd = -1, created = 0;
+    void* addr;
+
+    if (name == NULL) {
+        return NULL;
+    }
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    if (create) {
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0660);
+        if (fd >= 0) {
+            created = 1;
+            if (ftruncate(fd, sizeof(ShmQueueHeader) + size) != 0) {
+                goto fail;
+            }
+        }
+    }
+    if (fd < 0) {
+        fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0) {
+            return NULL;
+        }
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size <= sizeof(ShmQueueHeader)) {
+        goto fail;
+    }
+
+    addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        goto fail;
+    }
+    q = (ShmQueueData* )malloc(sizeof(ShmQueueData));
+    if (q == NULL) {
+        munmap(addr, st.st_size);
+        goto fail;
+    }
+    q->header = (ShmQueueHeader* )addr;
+    q->data = (char* )addr + sizeof(ShmQueueHeader);
+    q->map_size = st.st_size;
+    q->reserve_pos = 0;
+    q->reserve_len = 0;
+    q->reserved = 0;
+    q->peek_size = 0;
+    q->fd = fd;
+
+    if (created) {
+        if (ShmQueueInitHeader(q->header, size) != 0) {
+            goto fail;
+        }
+    } else if (__atomic_load_n(&(q->header->magic), __ATOMIC_ACQUIRE) != SHM_QUEUE_MAGIC ||
+               q->header->version != SHM_QUEUE_VERSION ||
+               q->header->capacity == 0 || (q->header->capacity & (q->header->capacity - 1)) != 0 ||
+               sizeof(ShmQueueHeader) + q->header->capacity > q->map_size) {
+        goto fail;
+    }
+    q->capacity = q->header->capacity;
+    return q;
+
+fail:
+    if (q != NULL) {
+        munmap(q->header, q->map_size);
+        free(q);
+    }
+    if (created) {
+        shm_unlink(name);
+    }
+    close(fd);
+    return NULL;
+}
+
+/*
+* @brief      获取生产者锁
+* @note       持锁进程崩溃时恢复锁；崩溃进程的预留未提交，写位置不受影响
+* @param[in]  header  共享内存头部
+* @return     0    成功
+* @return     -1   失败
+*/
+static int ShmQueueLock(ShmQueueHeader* header)
+{
+    int ret = pthread_mutex_lock(&(header->producer_lock));
+
+    if (ret == EOWNERDEAD) {
+        ret = pthread_mutex_consistent(&(header->producer_lock));
+    }
+    return ret == 0 ? 0 : -1;
+}
+
+/*
+* @brief      预留一条记录
+* @note       返回共享内存中的写入地址，写完后调用ShmQueueCommit；
+*             预留期间持有生产者锁，其他生产者等待；队列满等待空间时不持有锁
+* @param[in]  q    队列结构体
+* @param[in]  len  数据长度，不能超过容量的一半
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     写入地址，空间不足超时或失败返回NULL
+*/
+void* ShmQueueReserve(ShmQueueData* q, size_t len, struct timeval* tv)
+{
+    ShmQueueHeader* header;
+    ShmRecord* pad;
+    struct timespec ts;
+    uint64_t tail, head, capacity;
+    size_t total, offset, to_end, need;
+    uint32_t seq;
+
+    if (q == NULL) {
+        return NULL;
+    }
+    header = q->header;
+    capacity = q->capacity;
+    total = SHM_RECORD_SIZE(len);
+    if (total > capacity / 2) {
+        errno = EMSGSIZE;
+        return NULL;
+    }
+    if (tv != NULL) {
+        ShmQueueDeadline(tv, &ts);
+    }
+    if (ShmQueueLock(header) != 0) {
+        return NULL;
+    }
+
+    for (;;) {
+        tail = header->tail;
+        offset = tail & (capacity - 1);
+        to_end = capacity - offset;
+        /* 尾部放不下时用填充记录跳到数据区起始处 */
+        need = total + (to_end < total ? to_end : 0);
+        head = __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE);
+        if (capacity - (tail - head) >= need) {
+            break;
+        }
+        if (tv != NULL && tv->tv_sec == 0 && tv->tv_usec == 0) {
+            goto timeout;
+        }
+        seq = __atomic_load_n(&(header->head_seq), __ATOMIC_ACQUIRE);
+        __atomic_store_n(&(header->producer_waiting), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        head = __atomic_load_n(&(header->head), __ATOMIC_ACQUIRE);
+        if (capacity - (tail - head) >= need) {
+            break;
+        }
+        /* 等待期间释放生产者锁，不等待的生产者只在队列满时失败，不被阻塞 */
+        pthread_mutex_unlock(&(header->producer_lock));
+        if (ShmFutexWait(&(header->head_seq), seq, tv != NULL ? &ts : NULL) != 0) {
+            errno = ETIMEDOUT;
+            return NULL;
+        }
+        if (ShmQueueLock(header) != 0) {
+            return NULL;
+        }
+    }
+
+    if (to_end < total) {
+        pad = (ShmRecord* )(q->data + offset);
+        pad->len = to_end - sizeof(ShmRecord);
+        pad->type = SHM_RECORD_PAD;
+        tail += to_end;
+        offset = 0;
+    }
+    q->reserve_pos = tail;
+    q->reserve_len = len;
+    q->reserved = 1;
+    return q->data + offset + sizeof(ShmRecord);
+
+timeout:
+    pthread_mutex_unlock(&(header->producer_lock));
+    errno = ETIMEDOUT;
+    return NULL;
+}
+
+/*
+* @brief      提交预留的记录
+* @note       写位置此时才前移，消费者可见
+* @param[in]  q    队列结构体
+* @param[in]  len  实际数据长度，不超过预留长度
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueCommit(ShmQueueData* q, size_t len)
+{
+    ShmQueueHeader* header;
+    ShmRecord* record;
+
+    if (q == NULL || !q->reserved || len > q->reserve_len) {
+        return -1;
+    }
+    header = q->header;
+    record = (ShmRecord* )(q->data + (q->reserve_pos & (q->capacity - 1)));
+    record->len = len;
+    record->type = SHM_RECORD_DATA;
+
+    __atomic_store_n(&(header->tail), q->reserve_pos + SHM_RECORD_SIZE(len), __ATOMIC_RELEASE);
+    q->reserved = 0;
+    pthread_mutex_unlock(&(header->producer_lock));
+
+    ShmFutexWake(&(header->tail_seq), &(header->consumer_waiting));
+    return 0;
+}
+
+/*
+* @brief      写入一条记录
+* @note       预留、复制、提交
+* @param[in]  q    队列结构体
+* @param[in]  buf  数据
+* @param[in]  len  数据长度
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     0    成功
+* @return     -1   失败或超时
+*/
+int ShmQueuePush(ShmQueueData* q, const void* buf, size_t len, struct timeval* tv)
+{
+    void* addr = ShmQueueReserve(q, len, tv);
+
+    if (addr == NULL) {
+        return -1;
+    }
+    memcpy(addr, buf, len);
+    return ShmQueueCommit(q, len);
+}
+
+/*
+* @brief      查看队首记录
+* @note       只能有一个消费者；返回共享内存中的地址，处理完调用ShmQueueRelease，
+*             释放前消费者崩溃，重新打开后会再次读到该记录；记录头由生产者写入，长度超出
+*             已提交数据或数据区时丢弃到写位置；返回后生产者仍可改写该内存，不可信时先复制
+* @param[in]  q    队列结构体
+* @param[out] len  数据长度
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     数据地址，超时或失败返回NULL
+*/
+void* ShmQueuePeek(ShmQueueData* q, size_t* len, struct timeval* tv)
+{
+    ShmQueueHeader* header;
+    ShmRecord* record;
+    struct timespec ts;
+    uint64_t head, tail, capacity, offset, size;
+    uint32_t seq, rec_len, type;
+
+    if (q == NULL || len == NULL) {
+        return NULL;
+    }
+    header = q->header;
+    if (tv != NULL) {
+        ShmQueueDeadline(tv, &ts);
+    }
+
+    capacity = q->capacity;
+    for (;;) {
+        head = header->head;
+        tail = __atomic_load_n(&(header->tail), __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            offset = head & (capacity - 1);
+            record = (ShmRecord* )(q->data + offset);
+            if ((tail - head > capacity) || (tail - head < sizeof(ShmRecord)) ||
+                (offset + sizeof(ShmRecord) > capacity)) {
+                goto corrupt;
+            }
+            /* 记录头只读一次，校验后生产者再改写也不影响读位置 */
+            rec_len = __atomic_load_n(&(record->len), __ATOMIC_RELAXED);
+            type = __atomic_load_n(&(record->type), __ATOMIC_RELAXED);
+            size = (type == SHM_RECORD_PAD) ? sizeof(ShmRecord) + rec_len : SHM_RECORD_SIZE((uint64_t)rec_len);
+            if ((type > SHM_RECORD_PAD) || (size > tail - head) || (offset + size > capacity) ||
+                ((type == SHM_RECORD_PAD) && (offset + size != capacity))) {
+                goto corrupt;
+            }
+            if (type == SHM_RECORD_PAD) {
+                __atomic_store_n(&(header->head), head + size, __ATOMIC_RELEASE);
+                continue;
+            }
+            *len = rec_len;
+            q->peek_size = size;
+            return record + 1;
+
+corrupt:
+            /* 无法找到下一条记录的边界，丢弃已提交的全部数据 */
+            __atomic_store_n(&(header->head), tail, __ATOMIC_RELEASE);
+            ShmFutexWake(&(header->head_seq), &(header->producer_waiting));
+            continue;
+        }
+
+        if (tv != NULL && tv->tv_sec == 0 && tv->tv_usec == 0) {
+            return NULL;
+        }
+        seq = __atomic_load_n(&(header->tail_seq), __ATOMIC_ACQUIRE);
+        __atomic_store_n(&(header->consumer_waiting), 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&(header->tail), __ATOMIC_ACQUIRE) != head) {
+            continue;
+        }
+        if (ShmFutexWait(&(header->tail_seq), seq, tv != NULL ? &ts : NULL) != 0) {
+            errno = ETIMEDOUT;
+            return NULL;
+        }
+    }
+}
+
+/*
+* @brief      释放队首记录
+* @note       读位置此时才前移，空间交还生产者
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueRelease(ShmQueueData* q)
+{
+    ShmQueueHeader* header;
+
+    if (q == NULL || q->peek_size == 0) {
+        return -1;
+    }
+    header = q->header;
+    __atomic_store_n(&(header->head), header->head + q->peek_size, __ATOMIC_RELEASE);
+    q->peek_size = 0;
+
+    ShmFutexWake(&(header->head_seq), &(header->producer_waiting));
+    return 0;
+}
+
+/*
+* @brief      关闭共享内存队列
+* @note       只解除本进程映射，共享内存保留
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueClose(ShmQueueData* q)
+{
+    if (q == NULL) {
+        return -1;
+    }
+    if (q->reserved) {
+        pthread_mutex_unlock(&(q->header->producer_lock));
+    }
+    munmap(q->header, q->map_size);
+    close(q->fd);
+    free(q);
+    return 0;
+}
+
+/*
+* @brief      删除共享内存
+* @note
+* @param[in]  name  共享内存名称
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueUnlink(const char* name)
+{
+    return shm_unlink(name);
+}
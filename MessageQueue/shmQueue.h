@@ -0,0 +1,171 @@
+/**
+* @file      shmQueue.h
+* @brief     共享内存进程间队列头文件
+*
+* 环形缓冲区位于shm_open/mmap共享内存中，记录变长，读写都在共享内存上原地进行；
+* 等待使用进程共享futex，读写位置只在提交/释放时前移，进程崩溃不会留下半条记录
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#ifndef __SHM_QUEUE_H__INCLUDE_
+#define __SHM_QUEUE_H__INCLUDE_
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE     64          /* 缓存行大小 */
+#endif
+
+#define SHM_QUEUE_MAGIC         0x53484d51  /* "SHMQ" */
+#define SHM_QUEUE_VERSION       1
+#define SHM_QUEUE_MIN_SIZE      4096        /* 最小数据区字节数 */
+#define SHM_RECORD_ALIGN        8           /* 记录按8字节对齐 */
+
+#define SHM_RECORD_DATA         0           /* 数据记录 */
+#define SHM_RECORD_PAD          1           /* 填充记录，数据区尾部放不下时回绕 */
+
+/*
+* @brief      记录头
+*/
+typedef struct ShmRecord{
+    uint32_t    len;                    /* 数据长度 */
+    uint32_t    type;                   /* 记录类型 */
+}ShmRecord;
+
+/*
+* @brief      共享内存头部
+* @note       位于共享内存起始处，数据区紧随其后；生产者和消费者字段各占一个缓存行
+*/
+typedef struct ShmQueueHeader{
+    uint32_t        magic;                      /* 初始化完成标志 */
+    uint32_t        version;                    /* 布局版本 */
+    uint64_t        capacity;                   /* 数据区字节数，2的幂 */
+    pthread_mutex_t producer_lock;              /* 生产者互斥锁，进程共享且健壮 */
+    char            pad0[2 * CACHE_LINE_SIZE - 16 - sizeof(pthread_mutex_t)];
+    uint64_t        tail;                       /* 已提交的写位置 */
+    uint32_t        tail_seq;                   /* 消费者等待的futex */
+    uint32_t        consumer_waiting;           /* 消费者正在等待 */
+    char            pad1[CACHE_LINE_SIZE - 16];
+    uint64_t        head;                       /* 已释放的读位置 */
+    uint32_t        head_seq;                   /* 生产者等待的futex */
+    uint32_t        producer_waiting;           /* 生产者正在等待 */
+    char            pad2[CACHE_LINE_SIZE - 16];
+}ShmQueueHeader;
+
+/*
+* @brief      共享内存队列句柄
+* @note       每个进程各自持有，不在共享内存中
+*/
+typedef struct ShmQueue{
+    ShmQueueHeader* header;                     /* 共享内存头部 */
+    char*           data;                       /* 数据区 */
+    size_t          map_size;                   /* 映射长度 */
+    uint64_t        capacity;                   /* 打开时校验过的数据区字节数，共享内存中的值可被改写，不再读取 */
+    uint64_t        reserve_pos;                /* 生产者：预留记录位置 */
+    size_t          reserve_len;                /* 生产者：预留数据长度 */
+    int             reserved;                   /* 生产者：持有预留，即持有生产者锁 */
+    size_t          peek_size;                  /* 消费者：当前记录占用字节数 */
+    int             fd;                         /* 共享内存fd */
+}ShmQueueData;
+
+/*
+* @brief      打开共享内存队列
+* @note       create为1且不存在时创建并初始化，已存在时沿用其中的读写位置；
+*             create为0时只打开已初始化的队列
+* @param[in]  name      共享内存名称，以'/'开头
+* @param[in]  capacity  数据区字节数，向上取整为2的幂
+* @param[in]  create    是否创建
+* @return     队列指针，失败返回NULL
+*/
+ShmQueueData* ShmQueueOpen(const char* , size_t , int );
+
+/*
+* @brief      预留一条记录
+* @note       返回共享内存中的写入地址，写完后调用ShmQueueCommit；
+*             预留期间持有生产者锁，其他生产者等待；队列满等待空间时不持有锁
+* @param[in]  q    队列结构体
+* @param[in]  len  数据长度，不能超过容量的一半
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     写入地址，空间不足超时或失败返回NULL
+*/
+void* ShmQueueReserve(ShmQueueData* , size_t , struct timeval* );
+
+/*
+* @brief      提交预留的记录
+* @note       写位置此时才前移，消费者可见
+* @param[in]  q    队列结构体
+* @param[in]  len  实际数据长度，不超过预留长度
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueCommit(ShmQueueData* , size_t );
+
+/*
+* @brief      写入一条记录
+* @note       预留、复制、提交
+* @param[in]  q    队列结构体
+* @param[in]  buf  数据
+* @param[in]  len  数据长度
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     0    成功
+* @return     -1   失败或超时
+*/
+int ShmQueuePush(ShmQueueData* , const void* , size_t , struct timeval* );
+
+/*
+* @brief      查看队首记录
+* @note       只能有一个消费者；返回共享内存中的地址，处理完调用ShmQueueRelease，
+*             释放前消费者崩溃，重新打开后会再次读到该记录；记录头由生产者写入，长度超出
+*             已提交数据或数据区时丢弃到写位置；返回后生产者仍可改写该内存，不可信时先复制
+* @param[in]  q    队列结构体
+* @param[out] len  数据长度
+* @param[in]  tv   超时时间，NULL一直等待，0不等待
+* @return     数据地址，超时或失败返回NULL
+*/
+void* ShmQueuePeek(ShmQueueData* , size_t* , struct timeval* );
+
+/*
+* @brief      释放队首记录
+* @note       读位置此时才前移，空间交还生产者
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueRelease(ShmQueueData* );
+
+/*
+* @brief      关闭共享内存队列
+* @note       只解除本进程映射，共享内存保留
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueClose(ShmQueueData* );
+
+/*
+* @brief      删除共享内存
+* @note
+* @param[in]  name  共享内存名称
+* @return     0    成功
+* @return     -1   失败
+*/
+int ShmQueueUnlink(const char* );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
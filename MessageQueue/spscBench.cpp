@@ -0,0 +1,152 @@
+/**
+* @file      spscBench.cpp
+* @brief     单生产者单消费者队列性能对比
+*
+* 对比SpscQueueData(单个/批量)、boost::lockfree::spsc_queue和AsyncQueueData
+* gcc -O2 -c spscQueue.c queue.c && g++ -O2 spscBench.cpp spscQueue.o queue.o -lpthread
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#if __has_include(<boost/lockfree/spsc_queue.hpp>)
+#include <boost/lockfree/spsc_queue.hpp>
+#define HAVE_BOOST_SPSC 1
+#endif
+
+#include "spscQueue.h"
+#include "queue.h"
+
+#define CAPACITY    4096
+#define ITEMS       (10 * 1000 * 1000)
+#define BATCH       64
+
+/*
+* @brief      计时并打印吞吐
+* @param[in]  name     名称
+* @param[in]  run      测试函数，返回校验和
+*/
+template <typename F>
+static void Bench(const char* name, F run)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sum = run();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t expect = (uint64_t)ITEMS * (ITEMS + 1) / 2;
+    printf("%-24s %8.2f Mops/s %s\n", name, ITEMS / sec / 1e6, sum == expect ? "" : "(checksum error)");
+}
+
+int main(int argc, char *argv[])
+{
+    Bench("SpscQueue", [] {
+        SpscQueueData* q = SpscQueueCreate(CAPACITY);
+        uint64_t sum = 0;
+        std::thread producer([q] {
+            for (uintptr_t i = 1; i <= ITEMS; i++) {
+                while (SpscQueuePush(q, (void* )i) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        void* data;
+        for (int i = 0; i < ITEMS; i++) {
+            while (SpscQueuePop(q, &data) != 0) {
+                std::this_thread::yield();
+            }
+            sum += (uintptr_t)data;
+        }
+        producer.join();
+        SpscQueueFree(q);
+        return sum;
+    });
+
+    Bench("SpscQueue batch", [] {
+        SpscQueueData* q = SpscQueueCreate(CAPACITY);
+        uint64_t sum = 0;
+        std::thread producer([q] {
+            void* items[BATCH];
+            uintptr_t next = 1;
+            while (next <= ITEMS) {
+                int n = 0;
+                for (uintptr_t i = next; i <= ITEMS && n < BATCH; i++) {
+                    items[n++] = (void* )i;
+                }
+                int done = 0;
+                while (done < n) {
+                    int pushed = SpscQueuePushBatch(q, items + done, n - done);
+                    if (pushed == 0) {
+                        std::this_thread::yield();
+                    }
+                    done += pushed;
+                }
+                next += n;
+            }
+        });
+        void* out[BATCH];
+        for (int got = 0; got < ITEMS;) {
+            int n = SpscQueuePopBatch(q, out, BATCH);
+            for (int i = 0; i < n; i++) {
+                sum += (uintptr_t)out[i];
+            }
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            got += n;
+        }
+        producer.join();
+        SpscQueueFree(q);
+        return sum;
+    });
+
+#ifdef HAVE_BOOST_SPSC
+    Bench("boost spsc_queue", [] {
+        boost::lockfree::spsc_queue<uintptr_t> q(CAPACITY);
+        uint64_t sum = 0;
+        std::thread producer([&q] {
+            for (uintptr_t i = 1; i <= ITEMS; i++) {
+                while (!q.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        uintptr_t data;
+        for (int i = 0; i < ITEMS; i++) {
+            while (!q.pop(data)) {
+                std::this_thread::yield();
+            }
+            sum += data;
+        }
+        producer.join();
+        return sum;
+    });
+#else
+    printf("%-24s skipped, boost not found\n", "boost spsc_queue");
+#endif
+
+    Bench("AsyncQueue", [] {
+        AsyncQueueData* q = AsyncQueueDataCreate(CAPACITY);
+        uint64_t sum = 0;
+        std::thread producer([q] {
+            for (uintptr_t i = 1; i <= ITEMS; i++) {
+                AsyncQueuePushTail(q, (void* )i);
+            }
+        });
+        for (int i = 0; i < ITEMS; i++) {
+            sum += (uintptr_t)AsyncQueuePopHead(q, NULL);
+        }
+        producer.join();
+        AsyncQueueFree(q);
+        return sum;
+    });
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+* @file      spscQueue.c
+* @brief     单生产者单消费者队列源文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#include "spscQueue.h"
+#define DEFAULT_SIZE    1024
+
+/*
+* @brief      单生产者单消费者队列创建
+* @note       容量向上取整为2的幂
+* @param[in]  size    队列长度
+* @return     队列指针
+*/
+SpscQueueData* SpscQueueCreate(int size)
+{
+    SpscQueueData* q = NULL;
+    size_t capcity = 2;
+
+    if (size <= 0) {
+        size = DEFAULT_SIZE;
+    }
+    while (capcity < (size_t)size) {
+        capcity <<= 1;
+    }
+
+    if (posix_memalign((void** )&q, CACHE_LINE_SIZE, sizeof(SpscQueueData)) != 0) {
+        return NULL;
+    }
+    q->buf = (void** )malloc(capcity * sizeof(void* ));
+    if (q->buf == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->mask = capcity - 1;
+    q->tail = q->head_cache = 0;
+    q->head = q->tail_cache = 0;
+    return q;
+}
+
+/*
+* @brief      生产者可写空间
+* @note       缓存的读位置不足时才读取消费者缓存行
+* @param[in]  q    队列结构体
+* @param[in]  want 需要的空间
+* @return     可写个数
+*/
+static size_t SpscQueueWritable(SpscQueueData* q, size_t want)
+{
+    size_t capcity = q->mask + 1;
+    size_t free_size = capcity - (q->tail - q->head_cache);
+
+    if (free_size < want) {
+        q->head_cache = __atomic_load_n(&(q->head), __ATOMIC_ACQUIRE);
+        free_size = capcity - (q->tail - q->head_cache);
+    }
+    return free_size;
+}
+
+/*
+* @brief      消费者可读个数
+* @note       缓存的写位置不足时才读取生产者缓存行
+* @param[in]  q    队列结构体
+* @param[in]  want 需要的个数
+* @return     可读个数
+*/
+static size_t SpscQueueAvail(SpscQueueData* q, size_t want)
+{
+    size_t avail = q->tail_cache - q->head;
+
+    if (avail < want) {
+        q->tail_cache = __atomic_load_n(&(q->tail), __ATOMIC_ACQUIRE);
+        avail = q->tail_cache - q->head;
+    }
+    return avail;
+}
+
+/*
+* @brief      尾部插入元素
+* @note       只能由生产者线程调用，不阻塞
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     -1   队列满
+*/
+int SpscQueuePush(SpscQueueData* q, void* data)
+{
+    if (SpscQueueWritable(q, 1) == 0) {
+        return -1;
+    }
+    q->buf[q->tail & q->mask] = data;
+    __atomic_store_n(&(q->tail), q->tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+* @brief      头部取出元素
+* @note       只能由消费者线程调用，不阻塞
+* @param[in]  q    队列结构体
+* @param[out] data 数据
+* @return     0    成功
+* @return     -1   队列空
+*/
+int SpscQueuePop(SpscQueueData* q, void** data)
+{
+    if (SpscQueueAvail(q, 1) == 0) {
+        return -1;
+    }
+    *data = q->buf[q->head & q->mask];
+    __atomic_store_n(&(q->head), q->head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+* @brief      批量插入元素
+* @note       只能由生产者线程调用，一次发布写位置
+* @param[in]  q     队列结构体
+* @param[in]  items 数据数组
+* @param[in]  n     数据个数
+* @return     实际插入个数
+*/
+int SpscQueuePushBatch(SpscQueueData* q, void** items, int n)
+{
+    size_t count, i, tail = q->tail;
+
+    if (n <= 0) {
+        return 0;
+    }
+    count = SpscQueueWritable(q, (size_t)n);
+    if (count > (size_t)n) {
+        count = (size_t)n;
+    }
+    for (i = 0; i < count; i++) {
+        q->buf[(tail + i) & q->mask] = items[i];
+    }
+    __atomic_store_n(&(q->tail), tail + count, __ATOMIC_RELEASE);
+    return (int)count;
+}
+
+/*
+* @brief      批量取出元素
+* @note       只能由消费者线程调用，一次发布读位置
+* @param[in]  q     队列结构体
+* @param[out] out   数据数组
+* @param[in]  max   最多取出个数
+* @return     实际取出个数
+*/
+int SpscQueuePopBatch(SpscQueueData* q, void** out, int max)
+{
+    size_t count, i, head = q->head;
+
+    if (max <= 0) {
+        return 0;
+    }
+    count = SpscQueueAvail(q, (size_t)max);
+    if (count > (size_t)max) {
+        count = (size_t)max;
+    }
+    for (i = 0; i < count; i++) {
+        out[i] = q->buf[(head + i) & q->mask];
+    }
+    __atomic_store_n(&(q->head), head + count, __ATOMIC_RELEASE);
+    return (int)count;
+}
+
+/*
+* @brief      队列元素个数
+* @note       并发时为近似值
+* @param[in]  q    队列结构体
+* @return     元素个数
+*/
+int SpscQueueSize(SpscQueueData* q)
+{
+    size_t tail = __atomic_load_n(&(q->tail), __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&(q->head), __ATOMIC_ACQUIRE);
+    return (int)(tail - head);
+}
+
+/*
+* @brief      释放队列
+* @note
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int SpscQueueFree(SpscQueueData* q)
+{
+    if ((q == NULL) || (q->buf == NULL)) {
+        return -1;
+    }
+    free(q->buf);
+    q->buf = NULL;
+    free(q);
+    return 0;
+}
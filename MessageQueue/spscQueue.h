@@ -0,0 +1,115 @@
+/**
+* @file      spscQueue.h
+* @brief     单生产者单消费者队列头文件
+*
+*
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+#ifndef __SPSC_QUEUE_H__INCLUDE_
+#define __SPSC_QUEUE_H__INCLUDE_
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE     64          /* 缓存行大小 */
+#endif
+
+/*
+* @brief      单生产者单消费者队列
+* @note       生产者和消费者字段各占一个缓存行，并缓存对方位置，
+*             只有缓存判断为满或空时才读取对方缓存行
+*/
+typedef struct SpscQueue{
+    void**  buf;                                                /* 数据 */
+    size_t  mask;                                               /* 容量减一，容量为2的幂 */
+    char    pad0[CACHE_LINE_SIZE - sizeof(void**) - sizeof(size_t)];
+    size_t  tail;                                               /* 生产者：写位置 */
+    size_t  head_cache;                                         /* 生产者：缓存的读位置 */
+    char    pad1[CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+    size_t  head;                                               /* 消费者：读位置 */
+    size_t  tail_cache;                                         /* 消费者：缓存的写位置 */
+    char    pad2[CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+}SpscQueueData;
+
+/*
+* @brief      单生产者单消费者队列创建
+* @note       容量向上取整为2的幂
+* @param[in]  size    队列长度
+* @return     队列指针
+*/
+SpscQueueData* SpscQueueCreate(int );
+
+/*
+* @brief      尾部插入元素
+* @note       只能由生产者线程调用，不阻塞
+* @param[in]  q    队列结构体
+* @param[in]  data 数据
+* @return     0    成功
+* @return     -1   队列满
+*/
+int SpscQueuePush(SpscQueueData* , void* );
+
+/*
+* @brief      头部取出元素
+* @note       只能由消费者线程调用，不阻塞
+* @param[in]  q    队列结构体
+* @param[out] data 数据
+* @return     0    成功
+* @return     -1   队列空
+*/
+int SpscQueuePop(SpscQueueData* , void** );
+
+/*
+* @brief      批量插入元素
+* @note       只能由生产者线程调用，一次发布写位置
+* @param[in]  q     队列结构体
+* @param[in]  items 数据数组
+* @param[in]  n     数据个数
+* @return     实际插入个数
+*/
+int SpscQueuePushBatch(SpscQueueData* , void** , int );
+
+/*
+* @brief      批量取出元素
+* @note       只能由消费者线程调用，一次发布读位置
+* @param[in]  q     队列结构体
+* @param[out] out   数据数组
+* @param[in]  max   最多取出个数
+* @return     实际取出个数
+*/
+int SpscQueuePopBatch(SpscQueueData* , void** , int );
+
+/*
+* @brief      队列元素个数
+* @note       并发时为近似值
+* @param[in]  q    队列结构体
+* @return     元素个数
+*/
+int SpscQueueSize(SpscQueueData* );
+
+/*
+* @brief      释放队列
+* @note
+* @param[in]  q    队列结构体
+* @return     0    成功
+* @return     -1   失败
+*/
+int SpscQueueFree(SpscQueueData* );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/**
+* @file      coDemo.cpp
+* @brief     线程池协程任务示例
+*
+* gcc -c threadPool.c ../MessageQueue/queue.c && g++ -std=c++20 coDemo.cpp threadPool.o queue.o -lpthread
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#include <atomic>
+#include <cstdio>
+
+#include "coTask.hpp"
+
+#define THREAD      2
+#define QUEUE       4096
+#define COROUTINES  1000
+
+static std::atomic<int> done(0);
+
+CoTask<int> Delay(CoScheduler &sched, int ms)
+{
+    co_await sched.SleepFor(std::chrono::milliseconds(ms));
+    co_return ms;
+}
+
+CoTask<> Sleeper(CoScheduler &sched, int id)
+{
+    int ms = co_await Delay(sched, 10 + id % 50);
+    (void)ms;
+    done++;
+}
+
+CoTask<> Reader(CoScheduler &sched, int fd)
+{
+    char buf[16] = {0};
+    co_await sched.Readable(fd);
+    (void)!read(fd, buf, sizeof(buf) - 1);
+    printf("pipe read: %s\n", buf);
+    done++;
+}
+
+CoTask<> Consumer(CoScheduler &sched, AsyncQueueData *mq)
+{
+    void *data = co_await sched.Pop(mq);
+    printf("queue pop: %d\n", *(int *)data);
+    done++;
+}
+
+int main(int argc, char *argv[])
+{
+    static int value = 42;
+    int fds[2];
+    ThreadPool *pool = ThreadPoolCreate(THREAD, QUEUE);
+    AsyncQueueData *mq = AsyncQueueDataCreate(16);
+
+    if (pool == NULL || mq == NULL || pipe(fds) != 0) {
+        return -1;
+    }
+
+    {
+        CoScheduler sched(pool);
+
+        for (int i = 0; i < COROUTINES; i++) {
+            sched.Spawn(Sleeper(sched, i));
+        }
+        sched.Spawn(Reader(sched, fds[0]));
+        sched.Spawn(Consumer(sched, mq));
+
+        (void)!write(fds[1], "hello", 5);
+        AsyncQueuePushTail(mq, &value);
+
+        while (done < COROUTINES + 2) {
+            usleep(10000);
+        }
+        printf("%d coroutines done on %d threads\n", done.load(), THREAD);
+    }
+
+    ThreadPoolDestroy(pool, GracefulShutDown);
+    AsyncQueueFree(mq);
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+}
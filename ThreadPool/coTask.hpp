@@ -0,0 +1,471 @@
+/**
+* @file      coTask.hpp
+* @brief     线程池协程任务头文件
+*
+* C++20协程任务类型，等待(定时器、队列、fd就绪)时挂起，就绪后在线程池工作线程上恢复
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __COTASK_HPP_
+#define __COTASK_HPP_
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "threadPool.h"
+#include "../MessageQueue/queue.h"
+
+template <typename T = void>
+class CoTask;
+
+/**
+* @brief           协程调度器
+* @note            任务在线程池上执行；一个反应线程负责定时器和fd就绪，只做唤醒不执行任务
+*/
+class CoScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto kPopRetry = std::chrono::milliseconds(1);    /* 就绪通知fd不可用时Pop的重试间隔 */
+
+    explicit CoScheduler(ThreadPool *pool)
+        : pool_(pool)
+    {
+        epfd_ = epoll_create1(EPOLL_CLOEXEC);
+        wakefd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakefd_;
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, wakefd_, &ev);
+
+        thread_ = std::thread([this] { Run(); });
+    }
+
+    ~CoScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stop_ = true;
+        }
+        Wake();
+        thread_.join();
+        close(wakefd_);
+        close(epfd_);
+    }
+
+    CoScheduler(const CoScheduler &) = delete;
+    CoScheduler &operator=(const CoScheduler &) = delete;
+
+    ThreadPool *Pool() const { return pool_; }
+
+    /**
+    * @brief      在线程池上恢复协程
+    * @note       队列满时暂存，由反应线程重试
+    * @param[in]  h       协程句柄
+    */
+    void Post(std::coroutine_handle<> h)
+    {
+        if (ThreadPoolAppend(pool_, &CoScheduler::Resume, h.address()) == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            overflow_.push_back(h);
+        }
+        Wake();
+    }
+
+    /**
+    * @brief      切换到线程池执行
+    */
+    auto Schedule()
+    {
+        struct Awaiter {
+            CoScheduler *sched;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { sched->Post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{this};
+    }
+
+    /**
+    * @brief      挂起指定时长
+    * @param[in]  delay   时长
+    */
+    auto SleepFor(Clock::duration delay)
+    {
+        struct Awaiter {
+            CoScheduler *sched;
+            Clock::time_point when;
+            bool await_ready() const noexcept { return when <= Clock::now(); }
+            void await_suspend(std::coroutine_handle<> h) { sched->AddTimer(when, h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{this, Clock::now() + delay};
+    }
+
+    /**
+    * @brief      等待fd可读
+    * @param[in]  fd      文件描述符，等待期间不能关闭
+    */
+    auto Readable(int fd) { return FdAwaiter{this, fd, false}; }
+
+    /**
+    * @brief      等待fd可写
+    * @param[in]  fd      文件描述符，等待期间不能关闭
+    */
+    auto Writable(int fd) { return FdAwaiter{this, fd, true}; }
+
+    /**
+    * @brief      从异步队列取出元素
+    * @note       队列空时在队列的就绪通知fd上挂起，不占用工作线程；
+    *             创建通知fd失败时退回每kPopRetry定时重试
+    * @param[in]  mq      队列指针，等待期间不能释放
+    * @return     元素指针
+    */
+    CoTask<void *> Pop(AsyncQueueData *mq);
+
+    /**
+    * @brief      启动协程任务，完成后自动释放
+    * @param[in]  task    协程任务
+    */
+    template <typename T>
+    void Spawn(CoTask<T> task)
+    {
+        Post(task.Detach());
+    }
+
+private:
+    struct FdAwaiter {
+        CoScheduler *sched;
+        int fd;
+        bool write;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { sched->AddFd(fd, write, h); }
+        void await_resume() const noexcept {}
+    };
+
+    struct Timer {
+        Clock::time_point when;
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer &other) const { return when > other.when; }
+    };
+
+    struct FdWaiters {
+        std::vector<std::coroutine_handle<>> readers;
+        std::vector<std::coroutine_handle<>> writers;
+        bool registered = false;
+    };
+
+    static void Resume(void *address)
+    {
+        std::coroutine_handle<>::from_address(address).resume();
+    }
+
+    void Wake()
+    {
+        uint64_t one = 1;
+        (void)!write(wakefd_, &one, sizeof(one));
+    }
+
+    void AddTimer(Clock::time_point when, std::coroutine_handle<> h)
+    {
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            earliest = timers_.empty() || when < timers_.top().when;
+            timers_.push(Timer{when, h});
+        }
+        if (earliest) {
+            Wake();
+        }
+    }
+
+    void AddFd(int fd, bool write, std::coroutine_handle<> h)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        FdWaiters &waiters = fds_[fd];
+        (write ? waiters.writers : waiters.readers).push_back(h);
+        Arm(fd, waiters);
+    }
+
+    /* 调用者持有mutex_ */
+    void Arm(int fd, FdWaiters &waiters)
+    {
+        struct epoll_event ev = {};
+        ev.events = EPOLLONESHOT;
+        if (!waiters.readers.empty()) {
+            ev.events |= EPOLLIN;
+        }
+        if (!waiters.writers.empty()) {
+            ev.events |= EPOLLOUT;
+        }
+        ev.data.fd = fd;
+        epoll_ctl(epfd_, waiters.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+        waiters.registered = true;
+    }
+
+    void Run()
+    {
+        struct epoll_event events[64];
+        std::vector<std::coroutine_handle<>> ready;
+
+        for (;;) {
+            int timeout = -1;
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                if (stop_) {
+                    break;
+                }
+                if (!overflow_.empty()) {
+                    timeout = 1;
+                } else if (!timers_.empty()) {
+                    auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers_.top().when - Clock::now());
+                    timeout = wait.count() > 0 ? (int)wait.count() : 0;
+                }
+            }
+
+            int n = epoll_wait(epfd_, events, 64, timeout);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == wakefd_) {
+                    uint64_t value;
+                    (void)!read(wakefd_, &value, sizeof(value));
+                    continue;
+                }
+                auto it = fds_.find(fd);
+                if (it == fds_.end()) {
+                    continue;
+                }
+                uint32_t mask = events[i].events;
+                FdWaiters &waiters = it->second;
+                if (mask & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    ready.insert(ready.end(), waiters.readers.begin(), waiters.readers.end());
+                    waiters.readers.clear();
+                }
+                if (mask & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    ready.insert(ready.end(), waiters.writers.begin(), waiters.writers.end());
+                    waiters.writers.clear();
+                }
+                if (waiters.readers.empty() && waiters.writers.empty()) {
+                    epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+                    fds_.erase(it);
+                } else {
+                    Arm(fd, waiters);
+                }
+            }
+
+            auto now = Clock::now();
+            while (!timers_.empty() && timers_.top().when <= now) {
+                ready.push_back(timers_.top().handle);
+                timers_.pop();
+            }
+
+            std::deque<std::coroutine_handle<>> overflow;
+            overflow.swap(overflow_);
+            lock.unlock();
+
+            for (auto h : overflow) {
+                Post(h);
+            }
+            for (auto h : ready) {
+                Post(h);
+            }
+            ready.clear();
+        }
+    }
+
+    ThreadPool *pool_;
+    int epfd_ = -1;
+    int wakefd_ = -1;
+    std::thread thread_;
+    std::mutex mutex_;
+    bool stop_ = false;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::unordered_map<int, FdWaiters> fds_;
+    std::deque<std::coroutine_handle<>> overflow_;
+};
+
+/**
+* @brief           协程结束时的等待体
+* @note            有等待者则对称转移到等待者，由Spawn启动的任务自行销毁
+*/
+struct CoFinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+    {
+        auto &promise = h.promise();
+        if (promise.continuation) {
+            return promise.continuation;
+        }
+        if (promise.detached) {
+            h.destroy();
+        }
+        return std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+/**
+* @brief           协程任务promise公共部分
+*/
+template <typename T>
+struct CoPromiseBase {
+    std::coroutine_handle<> continuation;   /* co_await本任务的协程 */
+    std::exception_ptr exception;
+    bool detached = false;                  /* 由Spawn启动，结束时自行销毁 */
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    CoFinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+/**
+* @brief           协程任务
+* @note            惰性启动：co_await时在当前线程开始执行，或通过CoScheduler::Spawn在线程池上启动
+*/
+template <typename T>
+class CoTask {
+public:
+    struct promise_type : CoPromiseBase<T> {
+        std::optional<T> value;
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_value(T v) { value = std::move(v); }
+    };
+
+    CoTask(CoTask &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask(const CoTask &) = delete;
+    CoTask &operator=(const CoTask &) = delete;
+    ~CoTask()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    auto operator co_await() &&
+    {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept
+            {
+                handle.promise().continuation = h;
+                return handle;
+            }
+            T await_resume()
+            {
+                if (handle.promise().exception) {
+                    std::rethrow_exception(handle.promise().exception);
+                }
+                return std::move(*handle.promise().value);
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+    std::coroutine_handle<> Detach()
+    {
+        handle_.promise().detached = true;
+        return std::exchange(handle_, nullptr);
+    }
+
+private:
+    explicit CoTask(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class CoTask<void> {
+public:
+    struct promise_type : CoPromiseBase<void> {
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_void() noexcept {}
+    };
+
+    CoTask(CoTask &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask(const CoTask &) = delete;
+    CoTask &operator=(const CoTask &) = delete;
+    ~CoTask()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    auto operator co_await() &&
+    {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept
+            {
+                handle.promise().continuation = h;
+                return handle;
+            }
+            void await_resume()
+            {
+                if (handle.promise().exception) {
+                    std::rethrow_exception(handle.promise().exception);
+                }
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+    std::coroutine_handle<> Detach()
+    {
+        handle_.promise().detached = true;
+        return std::exchange(handle_, nullptr);
+    }
+
+private:
+    explicit CoTask(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+inline CoTask<void *> CoScheduler::Pop(AsyncQueueData *mq)
+{
+    for (;;) {
+        void *data = AsyncQueueTryPop(mq);
+        if (data != nullptr) {
+            co_return data;
+        }
+        int armed = AsyncQueueEventArm(mq);
+        if (armed == 0) {
+            co_await Readable(AsyncQueueGetEventFd(mq));
+        } else if (armed < 0) {
+            co_await SleepFor(kPopRetry);
+        }
+    }
+}
+
+#endif /* __COTASK_HPP_ */
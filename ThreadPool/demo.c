@@ -7,6 +7,7 @@
 #include <assert.h>
 
 #include "threadPool.h"
+#include "timerWheel.h"
 
 int tasks = 0, done = 0;
 pthread_mutex_t lock;
@@ -34,12 +35,13 @@ int main(int argc, char **argv)
         tasks++;
         pthread_mutex_unlock(&lock);
     } */
+    /* 每隔1秒执行一个任务，由定时轮调度，不再阻塞提交线程 */
     for (int i = 0; i < QUEUE*20; i++) {
-        sleep(1);
-        if (ThreadPoolAppend(pool, &dummy_task, NULL) != 0) {
+        if (ThreadPoolSchedule(pool, i * 1000, &dummy_task, NULL) == 0) {
             printf("i this is error\n");
             return -1;
         }
+        tasks++;
     }
 
 /*     for (int j = 0; j < QUEUE; j++) {
@@ -51,7 +53,7 @@ int main(int argc, char **argv)
 
     fprintf(stderr, "Added %d tasks\n", tasks);
 
-    while((tasks / 2) > done) {
+    while(tasks > done) {
         usleep(10000);
     }
     assert(ThreadPoolDestroy(pool, 2) == 0);
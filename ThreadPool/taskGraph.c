@@ -0,0 +1,345 @@
+/**
+* @file      taskGraph.c
+* @brief     任务依赖图源文件
+*
+* 函数定义
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#include "taskGraph.h"
+
+static void TaskGraphNodeRun(void *arg);
+
+/**
+* @brief      提交就绪节点到线程池
+* @note       线程池队列满或已关闭时在当前线程直接执行，保证任务图能够完成
+* @param[in]  graph             任务图指针
+* @param[in]  node              就绪节点
+* @return     无
+*/
+static void TaskGraphSubmit(TaskGraph *graph, TaskGraphNode *node)
+{
+    if (ThreadPoolAppend(graph->pool, TaskGraphNodeRun, node) != 0) {
+        TaskGraphNodeRun(node);
+    }
+}
+
+/**
+* @brief      节点完成计数
+* @note       最后一个节点完成时唤醒等待者
+* @param[in]  graph             任务图指针
+* @return     无
+*/
+static void TaskGraphNodeDone(TaskGraph *graph)
+{
+    if (__atomic_sub_fetch(&(graph->remaining), 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&(graph->lock));
+    graph->running = 0;
+    pthread_cond_broadcast(&(graph->cond));
+    pthread_mutex_unlock(&(graph->lock));
+}
+
+/**
+* @brief      执行节点并释放后继
+* @note       第一个就绪的后继留在当前线程继续执行，其余提交到线程池
+* @param[in]  arg               节点指针
+* @return     无
+*/
+static void TaskGraphNodeRun(void *arg)
+{
+    TaskGraphNode *node = (TaskGraphNode *)arg;
+    TaskGraph *graph = node->graph;
+    TaskGraphNode *next, *succ;
+    int i;
+
+    while (node != NULL) {
+        (*(node->func))(node->arg);
+
+        next = NULL;
+        for (i = 0; i < node->successor_number; i++) {
+            succ = node->successors[i];
+            if (__atomic_sub_fetch(&(succ->pending), 1, __ATOMIC_ACQ_REL) != 0) {
+                continue;
+            }
+            if (next == NULL) {
+                next = succ;
+            } else {
+                TaskGraphSubmit(graph, succ);
+            }
+        }
+
+        TaskGraphNodeDone(graph);
+        node = next;
+    }
+}
+
+/**
+* @brief      检查任务图是否存在环
+* @note       拓扑排序，借用pending作为入度计数
+* @param[in]  graph             任务图指针
+* @return     0                 无环
+* @return     其他              有环
+*/
+static int TaskGraphCheckCycle(TaskGraph *graph)
+{
+    TaskGraphNode **stack;
+    TaskGraphNode *node;
+    int i, top = 0, visited = 0;
+
+    stack = (TaskGraphNode **)malloc(sizeof(TaskGraphNode *) * graph->node_number);
+    if (stack == NULL) {
+        return ThreadPoolInvalid;
+    }
+
+    for (i = 0; i < graph->node_number; i++) {
+        graph->nodes[i].pending = graph->nodes[i].dependency_number;
+        if (graph->nodes[i].pending == 0) {
+            stack[top++] = &(graph->nodes[i]);
+        }
+    }
+
+    while (top > 0) {
+        node = stack[--top];
+        visited++;
+        for (i = 0; i < node->successor_number; i++) {
+            if (--node->successors[i]->pending == 0) {
+                stack[top++] = node->successors[i];
+            }
+        }
+    }
+
+    free(stack);
+    return (visited == graph->node_number) ? 0 : ThreadPoolGraphCycle;
+}
+
+/**
+* @brief      创建任务图
+* @note
+* @param[in]  pool              线程池指针
+* @param[in]  max_nodes         最大节点数
+* @return     TaskGraph         任务图指针
+*/
+TaskGraph *TaskGraphCreate(ThreadPool *pool, int max_nodes)
+{
+    TaskGraph *graph;
+
+    if (pool == NULL || max_nodes <= 0 || max_nodes > MAX_GRAPH_NODES) {
+        return NULL;
+    }
+
+    if ((graph = (TaskGraph *)malloc(sizeof(TaskGraph))) == NULL) {
+        return NULL;
+    }
+
+    graph->nodes = (TaskGraphNode *)calloc(max_nodes, sizeof(TaskGraphNode));
+    if (graph->nodes == NULL) {
+        free(graph);
+        return NULL;
+    }
+
+    graph->pool = pool;
+    graph->node_number = 0;
+    graph->node_capacity = max_nodes;
+    graph->remaining = 0;
+    graph->running = 0;
+
+    if ((pthread_mutex_init(&(graph->lock), NULL) != 0) ||
+       (pthread_cond_init(&(graph->cond), NULL) != 0)) {
+        free(graph->nodes);
+        free(graph);
+        return NULL;
+    }
+
+    return graph;
+}
+
+/**
+* @brief      向任务图添加任务
+* @note       仅在任务图未执行时调用
+* @param[in]  graph             任务图指针
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     TaskGraphNode     节点指针，失败返回NULL
+*/
+TaskGraphNode *TaskGraphAddTask(TaskGraph *graph, void (*func)(void *), void *arg)
+{
+    TaskGraphNode *node;
+
+    if (graph == NULL || func == NULL || graph->running ||
+        graph->node_number >= graph->node_capacity) {
+        return NULL;
+    }
+
+    node = &(graph->nodes[graph->node_number++]);
+    node->func = func;
+    node->arg = arg;
+    node->graph = graph;
+    node->successors = NULL;
+    node->successor_number = 0;
+    node->successor_capacity = 0;
+    node->dependency_number = 0;
+    node->pending = 0;
+
+    return node;
+}
+
+/**
+* @brief      声明依赖关系，node在depend完成后执行
+* @note       仅在任务图未执行时调用
+* @param[in]  graph             任务图指针
+* @param[in]  node              后继节点
+* @param[in]  depend            前驱节点
+* @return     0                 成功
+* @return     其他              失败
+*/
+int TaskGraphAddDependency(TaskGraph *graph, TaskGraphNode *node, TaskGraphNode *depend)
+{
+    TaskGraphNode **successors;
+    int capacity;
+
+    if (graph == NULL || node == NULL || depend == NULL || node == depend ||
+        node->graph != graph || depend->graph != graph) {
+        return ThreadPoolInvalid;
+    }
+
+    if (graph->running) {
+        return ThreadPoolGraphBusy;
+    }
+
+    /* 后继数组按倍数扩容 */
+    if (depend->successor_number >= depend->successor_capacity) {
+        capacity = depend->successor_capacity ? depend->successor_capacity * 2 : 4;
+        successors = (TaskGraphNode **)realloc(depend->successors, sizeof(TaskGraphNode *) * capacity);
+        if (successors == NULL) {
+            return ThreadPoolInvalid;
+        }
+        depend->successors = successors;
+        depend->successor_capacity = capacity;
+    }
+
+    depend->successors[depend->successor_number++] = node;
+    node->dependency_number++;
+
+    return 0;
+}
+
+/**
+* @brief      执行任务图
+* @note       提交所有无前驱节点，后继由完成的前驱释放；可重复执行
+* @param[in]  graph             任务图指针
+* @return     0                 成功
+* @return     其他              失败
+*/
+int TaskGraphRun(TaskGraph *graph)
+{
+    TaskGraphNode **roots;
+    int i, root_number = 0, err;
+
+    if (graph == NULL) {
+        return ThreadPoolInvalid;
+    }
+
+    pthread_mutex_lock(&(graph->lock));
+    if (graph->running) {
+        pthread_mutex_unlock(&(graph->lock));
+        return ThreadPoolGraphBusy;
+    }
+    if (graph->node_number == 0) {
+        pthread_mutex_unlock(&(graph->lock));
+        return 0;
+    }
+
+    if ((err = TaskGraphCheckCycle(graph)) != 0) {
+        pthread_mutex_unlock(&(graph->lock));
+        return err;
+    }
+
+    roots = (TaskGraphNode **)malloc(sizeof(TaskGraphNode *) * graph->node_number);
+    if (roots == NULL) {
+        pthread_mutex_unlock(&(graph->lock));
+        return ThreadPoolInvalid;
+    }
+
+    /* 重置计数，先收集根节点，避免提交后与计数重置交叉 */
+    for (i = 0; i < graph->node_number; i++) {
+        graph->nodes[i].pending = graph->nodes[i].dependency_number;
+        if (graph->nodes[i].dependency_number == 0) {
+            roots[root_number++] = &(graph->nodes[i]);
+        }
+    }
+    __atomic_store_n(&(graph->remaining), graph->node_number, __ATOMIC_RELEASE);
+    graph->running = 1;
+    pthread_mutex_unlock(&(graph->lock));
+
+    for (i = 0; i < root_number; i++) {
+        TaskGraphSubmit(graph, roots[i]);
+    }
+
+    free(roots);
+    return 0;
+}
+
+/**
+* @brief      等待任务图执行完成
+* @note
+* @param[in]  graph             任务图指针
+* @return     0                 成功
+* @return     其他              失败
+*/
+int TaskGraphWait(TaskGraph *graph)
+{
+    if (graph == NULL) {
+        return ThreadPoolInvalid;
+    }
+
+    if (pthread_mutex_lock(&(graph->lock)) != 0) {
+        return ThreadPoolLockFailure;
+    }
+    while (graph->running) {
+        pthread_cond_wait(&(graph->cond), &(graph->lock));
+    }
+    pthread_mutex_unlock(&(graph->lock));
+
+    return 0;
+}
+
+/**
+* @brief      释放任务图
+* @note       执行中的任务图不能释放
+* @param[in]  graph             任务图指针
+* @return     0                 成功
+* @return     其他              失败
+*/
+int TaskGraphFree(TaskGraph *graph)
+{
+    int i;
+
+    if (graph == NULL) {
+        return ThreadPoolInvalid;
+    }
+
+    if (graph->running) {
+        return ThreadPoolGraphBusy;
+    }
+
+    for (i = 0; i < graph->node_number; i++) {
+        free(graph->nodes[i].successors);
+    }
+    free(graph->nodes);
+
+    pthread_mutex_destroy(&(graph->lock));
+    pthread_cond_destroy(&(graph->cond));
+    free(graph);
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+* @file      taskGraph.h
+* @brief     任务依赖图头文件
+*
+* 在线程池上按有向无环图调度任务，前驱全部完成后自动释放后继
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __TASKGRAPH_H_
+#define __TASKGRAPH_H_
+
+#include "threadPool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAX_GRAPH_NODES     4096        /* 单个任务图最大节点数 */
+
+typedef struct TaskGraph TaskGraph;
+
+/**
+* @brief           任务图节点结构体
+*/
+typedef struct TaskGraphNode {
+    void (*func)(void *);               /* 任务函数 */
+    void *arg;                          /* 传递功能参数 */
+    TaskGraph *graph;                   /* 所属任务图 */
+    struct TaskGraphNode **successors;  /* 后继节点 */
+    int successor_number;               /* 后继节点数 */
+    int successor_capacity;             /* 后继数组容量 */
+    int dependency_number;              /* 前驱节点数 */
+    int pending;                        /* 未完成前驱数，原子操作 */
+} TaskGraphNode;
+
+/**
+* @brief           任务图结构体
+*/
+struct TaskGraph {
+    ThreadPool *pool;                   /* 执行任务的线程池 */
+    TaskGraphNode *nodes;               /* 节点数组，创建后地址不变 */
+    int node_number;                    /* 节点数 */
+    int node_capacity;                  /* 节点数组容量 */
+    int remaining;                      /* 本轮未完成节点数，原子操作 */
+    int running;                        /* 是否正在执行 */
+    pthread_mutex_t lock;               /* 仅用于等待完成 */
+    pthread_cond_t cond;                /* 完成条件变量 */
+};
+
+/**
+* @brief      创建任务图
+* @note
+* @param[in]  pool              线程池指针
+* @param[in]  max_nodes         最大节点数
+* @return     TaskGraph         任务图指针
+*/
+TaskGraph*
+TaskGraphCreate(ThreadPool *pool, int max_nodes);
+
+/**
+* @brief      向任务图添加任务
+* @note       仅在任务图未执行时调用
+* @param[in]  graph             任务图指针
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     TaskGraphNode     节点指针，失败返回NULL
+*/
+TaskGraphNode*
+TaskGraphAddTask(TaskGraph *graph, void (*func)(void *), void *arg);
+
+/**
+* @brief      声明依赖关系，node在depend完成后执行
+* @note       仅在任务图未执行时调用
+* @param[in]  graph             任务图指针
+* @param[in]  node              后继节点
+* @param[in]  depend            前驱节点
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+TaskGraphAddDependency(TaskGraph *graph, TaskGraphNode *node, TaskGraphNode *depend);
+
+/**
+* @brief      执行任务图
+* @note       提交所有无前驱节点，后继由完成的前驱释放；可重复执行
+* @param[in]  graph             任务图指针
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+TaskGraphRun(TaskGraph *graph);
+
+/**
+* @brief      等待任务图执行完成
+* @note
+* @param[in]  graph             任务图指针
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+TaskGraphWait(TaskGraph *graph);
+
+/**
+* @brief      释放任务图
+* @note       执行中的任务图不能释放
+* @param[in]  graph             任务图指针
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+TaskGraphFree(TaskGraph *graph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TASKGRAPH_H_ */
@@ -13,11 +13,70 @@
 * | 1.0.0 | 2021-5-20 | xh | create |
 */
 
+#include <errno.h>
+#include <time.h>
 #include "threadPool.h"
 
+/**
+* @brief      计算单调时钟截止时间
+* @note
+* @param[in]  timeout_ms        毫秒数
+* @param[out] ts                截止时间
+* @return     无
+*/
+static void ThreadPoolDeadline(int timeout_ms, struct timespec *ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+/**
+* @brief      静止时唤醒等待者
+* @note       调用者持有锁
+* @param[in]  pool              线程池指针
+* @return     无
+*/
+static void ThreadPoolNotifyIdle(ThreadPool *pool)
+{
+    if (pool->count == 0 && pool->active == 0) {
+        pthread_cond_broadcast(&(pool->idle));
+    }
+}
+
+/**
+* @brief      等待线程池静止
+* @note       调用者持有锁
+* @param[in]  pool              线程池指针
+* @param[in]  timeout_ms        等待毫秒数，小于0表示不限
+* @return     0                 已静止
+* @return     ThreadPoolTimeout 超时
+*/
+static int ThreadPoolWaitIdle(ThreadPool *pool, int timeout_ms)
+{
+    struct timespec ts;
+
+    if (timeout_ms >= 0) {
+        ThreadPoolDeadline(timeout_ms, &ts);
+    }
+
+    while (pool->count > 0 || pool->active > 0) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&(pool->idle), &(pool->lock));
+        } else if (pthread_cond_timedwait(&(pool->idle), &(pool->lock), &ts) == ETIMEDOUT) {
+            return (pool->count > 0 || pool->active > 0) ? ThreadPoolTimeout : 0;
+        }
+    }
+    return 0;
+}
+
 /**
 * @brief      工作线程
-* @note  							
+* @note       每个任务只加锁一次：执行完成后持锁记账并直接取下一个任务
 * @param[in]  threadpool            线程池指针
 * @return     无                   		
 */
@@ -26,9 +85,8 @@ static void *ThreadPoolWork(void *threadpool)
     ThreadPool *pool = (ThreadPool *)threadpool;
     ThreadPoolTask task;
 
+    pthread_mutex_lock(&(pool->lock));
     for (;;) {
-        pthread_mutex_lock(&(pool->lock));
-
         /* 阻塞 */
         while ((pool->count == 0) && (!pool->shutdown)) {
             pthread_cond_wait(&(pool->cond), &(pool->lock));
@@ -41,23 +99,33 @@ static void *ThreadPoolWork(void *threadpool)
         }
 
         /* 加载任务 */
-        task.func = pool->queue[pool->head].func;
-        task.arg = pool->queue[pool->head].arg;
+        task = pool->queue[pool->head];
         pool->head = (pool->head + 1) % pool->queue_size;
         pool->count -= 1;
 
+        /* 已取消的任务直接丢弃 */
+        if (task.token != NULL && ThreadPoolCancelTokenIsCancelled(task.token)) {
+            pool->cancelled++;
+            ThreadPoolNotifyIdle(pool);
+            continue;
+        }
+
+        pool->active++;
         pthread_mutex_unlock(&(pool->lock));
 
         /* 执行任务 */
         (*(task.func))(task.arg);
-        printf("%d pool->count = %d \n", __LINE__, pool->count);
+
+        pthread_mutex_lock(&(pool->lock));
+        pool->active--;
+        pool->completed++;
+        ThreadPoolNotifyIdle(pool);
     }
 
     pool->start_thread_number--;
-
     pthread_mutex_unlock(&(pool->lock));
-    pthread_exit(NULL);
-    return(NULL);
+
+    return NULL;
 }
 
 /**
@@ -80,9 +148,9 @@ static int ThreadPoolFree(ThreadPool *pool)
         pool->threads = NULL;
         pool->queue = NULL;
 
-        pthread_mutex_lock(&(pool->lock));
         pthread_mutex_destroy(&(pool->lock));
         pthread_cond_destroy(&(pool->cond));
+        pthread_cond_destroy(&(pool->idle));
     }
     free(pool); 
     pool = NULL;   
@@ -99,14 +167,17 @@ static int ThreadPoolFree(ThreadPool *pool)
 ThreadPool *ThreadPoolCreate(int thread_number, int queue_size)
 {
     ThreadPool *pool;
-    int i;
+    pthread_condattr_t attr;
+    int i, err;
     /* (void) flags; */
 
     if (thread_number <= 0 || thread_number > MAX_THREADS || queue_size <= 0 || queue_size > MAX_QUEUE) {
         return NULL;
     }
 
-    if ((pool = (ThreadPool *)malloc(sizeof(ThreadPool))) == NULL) {
+    /* 按缓存行对齐分配，成员分组才有意义 */
+    if (posix_memalign((void **)&pool, CACHE_LINE_SIZE, sizeof(ThreadPool)) != 0) {
+        pool = NULL;
         goto err;
     }
 
@@ -115,16 +186,23 @@ ThreadPool *ThreadPoolCreate(int thread_number, int queue_size)
     pool->queue_size = queue_size;
     pool->head = pool->tail = pool->count = 0;
     pool->shutdown = pool->start_thread_number = 0;
+    pool->timer_wheel = NULL;
+    pool->timer_destroy = NULL;
+    pool->active = 0;
+    pool->completed = pool->cancelled = 0;
 
     /* 分配内存 */
     pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * thread_number);
     pool->queue = (ThreadPoolTask *)malloc(sizeof(ThreadPoolTask) * queue_size);
 
-    /* 初始化mutex和cond */
-    if ((pthread_mutex_init(&(pool->lock), NULL) != 0) ||
-       (pthread_cond_init(&(pool->cond), NULL) != 0) ||
-       (pool->threads == NULL) ||
-       (pool->queue == NULL)) {
+    /* 初始化mutex和cond，空闲条件变量用单调时钟计算期限 */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    err = (pthread_mutex_init(&(pool->lock), NULL) != 0) ||
+          (pthread_cond_init(&(pool->cond), NULL) != 0) ||
+          (pthread_cond_init(&(pool->idle), &attr) != 0);
+    pthread_condattr_destroy(&attr);
+    if (err || (pool->threads == NULL) || (pool->queue == NULL)) {
         goto err;
     }
 
@@ -159,6 +237,21 @@ ThreadPool *ThreadPoolCreate(int thread_number, int queue_size)
 * @return     其他              失败 		
 */
 int ThreadPoolAppend(ThreadPool *pool, void (*func)(void *), void *arg)
+{
+    return ThreadPoolAppendCancelable(pool, func, arg, NULL);
+}
+
+/**
+* @brief      添加可取消任务到线程池
+* @note       同一令牌可用于多个任务，取消后全部丢弃
+* @param[in]  pool              线程池指针
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @param[in]  token             取消令牌
+* @return     0                 成功
+* @return     其他              失败
+*/
+int ThreadPoolAppendCancelable(ThreadPool *pool, void (*func)(void *), void *arg, ThreadPoolCancelToken *token)
 {
     int err = 0;
     int next;
@@ -191,6 +284,7 @@ int ThreadPoolAppend(ThreadPool *pool, void (*func)(void *), void *arg)
         /* 增加到队列 */
         pool->queue[pool->tail].func = func;
         pool->queue[pool->tail].arg = arg;
+        pool->queue[pool->tail].token = token;
         pool->tail = next;
         pool->count += 1;
 
@@ -209,16 +303,19 @@ int ThreadPoolAppend(ThreadPool *pool, void (*func)(void *), void *arg)
 }
 
 /**
-* @brief      销毁线程池
-* @note  							
+* @brief      停止线程池并回收线程
+* @note
 * @param[in]  pool              线程池指针
 * @param[in]  flags             关闭标志
-* @return     0                 成功 
-* @return     其他              失败                   		
+* @param[in]  timeout_ms        优雅关闭的排空期限，小于0表示不限
+* @return     0                 成功
+* @return     ThreadPoolTimeout 超时，剩余任务被丢弃
+* @return     其他              失败
 */
-int ThreadPoolDestroy(ThreadPool *pool, int flags)
+static int ThreadPoolStop(ThreadPool *pool, int flags, int timeout_ms)
 {
-    int i, err = 0;
+    struct TimerWheel *wheel;
+    int i, err = 0, timeout = 0;
 
     if (pool == NULL) {
         return ThreadPoolInvalid;
@@ -232,15 +329,41 @@ int ThreadPoolDestroy(ThreadPool *pool, int flags)
 
         if (pool->shutdown) {
             err = ThreadPoolShutDown;
+            pthread_mutex_unlock(&(pool->lock));
             break;
         }
 
         /* 关闭标志判断 */
         pool->shutdown = (flags & GracefulShutDown) ? GracefulShutDown : ImmediateShutDown;
 
+        /* 摘下并停止定时轮，之后的调度和取消取不到它；刻度线程提交任务需要线程池锁，解锁后再停止 */
+        wheel = pool->timer_wheel;
+        pool->timer_wheel = NULL;
+        if (wheel != NULL) {
+            pthread_mutex_unlock(&(pool->lock));
+            pool->timer_destroy(wheel);
+            pthread_mutex_lock(&(pool->lock));
+        }
+
         /* 唤醒所有线程 */
-        if ((pthread_cond_broadcast(&(pool->cond)) != 0) ||
-           (pthread_mutex_unlock(&(pool->lock)) != 0)) {
+        if (pthread_cond_broadcast(&(pool->cond)) != 0) {
+            err = ThreadPoolLockFailure;
+            pthread_mutex_unlock(&(pool->lock));
+            break;
+        }
+
+        /* 期限内未排空，丢弃剩余任务，执行中的任务完成后线程退出 */
+        if (pool->shutdown == GracefulShutDown && timeout_ms >= 0 &&
+            ThreadPoolWaitIdle(pool, timeout_ms) == ThreadPoolTimeout) {
+            pool->cancelled += pool->count;
+            pool->count = 0;
+            pool->head = pool->tail;
+            pool->shutdown = ImmediateShutDown;
+            pthread_cond_broadcast(&(pool->cond));
+            timeout = 1;
+        }
+
+        if (pthread_mutex_unlock(&(pool->lock)) != 0) {
             err = ThreadPoolLockFailure;
             break;
         }
@@ -256,10 +379,118 @@ int ThreadPoolDestroy(ThreadPool *pool, int flags)
     if (!err) {
         ThreadPoolFree(pool);
     }
+    return (!err && timeout) ? ThreadPoolTimeout : err;
+}
+
+/**
+* @brief      销毁线程池
+* @note  							
+* @param[in]  pool              线程池指针
+* @param[in]  flags             关闭标志
+* @return     0                 成功 
+* @return     其他              失败                   		
+*/
+int ThreadPoolDestroy(ThreadPool *pool, int flags)
+{
+    return ThreadPoolStop(pool, flags, -1);
+}
+
+/**
+* @brief      在期限内排空后销毁线程池
+* @note       立即停止接收新任务；期限内未排空则丢弃剩余排队任务，
+*             执行中的任务执行完毕后线程退出。两种返回值下线程池均已释放
+* @param[in]  pool              线程池指针
+* @param[in]  timeout_ms        排空期限毫秒数，小于0表示不限
+* @return     0                 期限内排空
+* @return     ThreadPoolTimeout 超时，剩余任务被丢弃
+* @return     其他              失败
+*/
+int ThreadPoolDestroyTimed(ThreadPool *pool, int timeout_ms)
+{
+    return ThreadPoolStop(pool, GracefulShutDown, timeout_ms);
+}
+
+/**
+* @brief      等待线程池静止
+* @note       不停止接收任务，仅等待排队和执行中任务数均为0
+* @param[in]  pool              线程池指针
+* @param[in]  timeout_ms        等待毫秒数，小于0表示不限
+* @return     0                 已静止
+* @return     ThreadPoolTimeout 超时
+*/
+int ThreadPoolDrain(ThreadPool *pool, int timeout_ms)
+{
+    int err;
+
+    if (pool == NULL) {
+        return ThreadPoolInvalid;
+    }
+
+    if (pthread_mutex_lock(&(pool->lock)) != 0) {
+        return ThreadPoolLockFailure;
+    }
+    err = ThreadPoolWaitIdle(pool, timeout_ms);
+    pthread_mutex_unlock(&(pool->lock));
+
     return err;
 }
 
+/**
+* @brief      查询线程池状态
+* @note
+* @param[in]  pool              线程池指针
+* @param[out] status            状态
+* @return     0                 成功
+* @return     其他              失败
+*/
+int ThreadPoolGetStatus(ThreadPool *pool, ThreadPoolStatus *status)
+{
+    if (pool == NULL || status == NULL) {
+        return ThreadPoolInvalid;
+    }
 
+    if (pthread_mutex_lock(&(pool->lock)) != 0) {
+        return ThreadPoolLockFailure;
+    }
+    status->queued = pool->count;
+    status->active = pool->active;
+    status->threads = pool->start_thread_number;
+    status->quiescent = (pool->count == 0 && pool->active == 0);
+    status->completed = pool->completed;
+    status->cancelled = pool->cancelled;
+    pthread_mutex_unlock(&(pool->lock));
 
+    return 0;
+}
 
+/**
+* @brief      初始化取消令牌
+* @param[in]  token             取消令牌
+* @return     无
+*/
+void ThreadPoolCancelTokenInit(ThreadPoolCancelToken *token)
+{
+    __atomic_store_n(&(token->cancelled), 0, __ATOMIC_RELEASE);
+}
+
+/**
+* @brief      取消令牌关联的任务
+* @param[in]  token             取消令牌
+* @return     无
+*/
+void ThreadPoolCancelTokenCancel(ThreadPoolCancelToken *token)
+{
+    __atomic_store_n(&(token->cancelled), 1, __ATOMIC_RELEASE);
+}
 
+/**
+* @brief      查询令牌是否已取消
+* @note       供长任务在执行中自行检查
+* @param[in]  token             取消令牌
+* @return     1                 已取消
+* @return     0                 未取消
+*/
+int ThreadPoolCancelTokenIsCancelled(const ThreadPoolCancelToken *token)
+{
+    return __atomic_load_n(&(token->cancelled), __ATOMIC_ACQUIRE);
+}
@@ -28,6 +28,10 @@ extern "C" {
 #define MAX_THREADS     64          /* 最大线程数 */
 #define MAX_QUEUE       65536       /* 最大队列长度 */
 
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64          /* 缓存行大小 */
+#endif
+
 /**
 * @brief           线程池枚举
 */
@@ -38,32 +42,64 @@ typedef enum {
     ThreadPoolLockFailure    = -2,  /* 线程池lock失败 */
     ThreadPoolQueueFull      = -3,  /* 线程池队列满 */
     ThreadPoolShutDown       = -4,  /* 线程池停止 */
-    ThreadPoolThreadFailure  = -5   /* 线程池线程出错 */
+    ThreadPoolThreadFailure  = -5,  /* 线程池线程出错 */
+    ThreadPoolGraphCycle     = -6,  /* 任务图存在环 */
+    ThreadPoolGraphBusy      = -7,  /* 任务图正在执行 */
+    ThreadPoolTimeout        = -8   /* 等待超时 */
 } ThreadPoolEnum;
 
+/**
+* @brief           任务取消令牌
+* @note            置位后尚未执行的任务被直接丢弃，执行中的任务可自行查询
+*/
+typedef struct {
+    int cancelled;                  /* 取消标志，原子操作 */
+} ThreadPoolCancelToken;
+
 /**
 * @brief           线程池任务结构体
 */
 typedef struct {
     void (*func)(void *);           /* 任务函数 */
     void *arg;                      /* 传递功能参数 */
+    ThreadPoolCancelToken *token;   /* 取消令牌，可为NULL */
 } ThreadPoolTask;
 
+/**
+* @brief           线程池状态结构体
+*/
+typedef struct {
+    int queued;                     /* 排队任务数 */
+    int active;                     /* 执行中任务数 */
+    int threads;                    /* 存活线程数 */
+    int quiescent;                  /* 1表示无排队和执行中任务 */
+    unsigned long completed;        /* 已完成任务数 */
+    unsigned long cancelled;        /* 被取消或丢弃的任务数 */
+} ThreadPoolStatus;
+
 /**
 * @brief            线程池结构体
 */
 typedef struct ThreadPoolData {
-  pthread_mutex_t lock;             /* 线程互斥锁 */
-  pthread_cond_t cond;              /* 线程条件变量 */
+  /* 创建后只读，与锁分开，工作线程读取时不受锁所在缓存行争用影响 */
   pthread_t *threads;               /* 总线程 */  
   ThreadPoolTask *queue;            /* 任务队列 */
-  int thread_number;                /* 线程数 */
   int queue_size;                   /* 任务队列大小 */
+  struct TimerWheel *timer_wheel;   /* 定时轮，首次调度时创建 */
+  void (*timer_destroy)(struct TimerWheel *);   /* 定时轮销毁函数 */
+  /* 锁及其保护的状态，总在持锁时一起读写，放在同一组缓存行 */
+  pthread_mutex_t lock __attribute__((aligned(CACHE_LINE_SIZE)));  /* 线程互斥锁 */
   int head;                         /* 头 */
   int tail;                         /* 尾 */
   int count;                        /* 待执行任务数 */
+  int active;                       /* 执行中任务数 */
   int shutdown;                     /* 关闭状态，不接受新任务，阻塞队列保存信息 */
+  int thread_number;                /* 线程数 */
   int start_thread_number;          /* 开始线程数 */
+  unsigned long completed;          /* 已完成任务数 */
+  unsigned long cancelled;          /* 被取消或丢弃的任务数 */
+  pthread_cond_t cond;              /* 线程条件变量 */
+  pthread_cond_t idle;              /* 空闲条件变量，单调时钟 */
 } ThreadPool;
 
 /**
@@ -99,6 +135,80 @@ ThreadPoolAppend(ThreadPool *pool, void (*func)(void *), void *arg);
 int 
 ThreadPoolDestroy(ThreadPool *pool, int flags);
 
+/**
+* @brief      在期限内排空后销毁线程池
+* @note       立即停止接收新任务；期限内未排空则丢弃剩余排队任务，
+*             执行中的任务执行完毕后线程退出。两种返回值下线程池均已释放
+* @param[in]  pool              线程池指针
+* @param[in]  timeout_ms        排空期限毫秒数，小于0表示不限
+* @return     0                 期限内排空
+* @return     ThreadPoolTimeout 超时，剩余任务被丢弃
+* @return     其他              失败
+*/
+int
+ThreadPoolDestroyTimed(ThreadPool *pool, int timeout_ms);
+
+/**
+* @brief      等待线程池静止
+* @note       不停止接收任务，仅等待排队和执行中任务数均为0
+* @param[in]  pool              线程池指针
+* @param[in]  timeout_ms        等待毫秒数，小于0表示不限
+* @return     0                 已静止
+* @return     ThreadPoolTimeout 超时
+*/
+int
+ThreadPoolDrain(ThreadPool *pool, int timeout_ms);
+
+/**
+* @brief      查询线程池状态
+* @note
+* @param[in]  pool              线程池指针
+* @param[out] status            状态
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+ThreadPoolGetStatus(ThreadPool *pool, ThreadPoolStatus *status);
+
+/**
+* @brief      添加可取消任务到线程池
+* @note       同一令牌可用于多个任务，取消后全部丢弃
+* @param[in]  pool              线程池指针
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @param[in]  token             取消令牌
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+ThreadPoolAppendCancelable(ThreadPool *pool, void (*func)(void *), void *arg, ThreadPoolCancelToken *token);
+
+/**
+* @brief      初始化取消令牌
+* @param[in]  token             取消令牌
+* @return     无
+*/
+void
+ThreadPoolCancelTokenInit(ThreadPoolCancelToken *token);
+
+/**
+* @brief      取消令牌关联的任务
+* @param[in]  token             取消令牌
+* @return     无
+*/
+void
+ThreadPoolCancelTokenCancel(ThreadPoolCancelToken *token);
+
+/**
+* @brief      查询令牌是否已取消
+* @note       供长任务在执行中自行检查
+* @param[in]  token             取消令牌
+* @return     1                 已取消
+* @return     0                 未取消
+*/
+int
+ThreadPoolCancelTokenIsCancelled(const ThreadPoolCancelToken *token);
+
 #ifdef __cplusplus
 }
 #endif
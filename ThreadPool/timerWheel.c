@@ -0,0 +1,571 @@
+/**
+* @file      timerWheel.c
+* @brief     线程池定时轮源文件
+*
+* 函数定义
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#include <string.h>
+#include <time.h>
+#include "timerWheel.h"
+
+#define TIMER_FREE          0           /* 空闲 */
+#define TIMER_PENDING       1           /* 挂在轮上 */
+#define TIMER_FIRING        2           /* 正在提交到线程池 */
+#define TIMER_CANCELLED     3           /* 提交期间被取消 */
+#define MAX_FIRE_BATCH      256         /* 单次解锁提交的最大任务数 */
+
+#define TIMER_INDEX(wheel, n) \
+    (int)(((wheel)->current >> (TVR_BITS + (n) * TVN_BITS)) & TVN_MASK)
+
+/**
+* @brief      获取单调时间
+* @note
+* @return     毫秒数
+*/
+static uint64_t TimerNowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+* @brief      组合定时器ID
+* @note       低32位为节点编号加1，高32位为复用代数
+* @param[in]  node              定时器节点
+* @return     定时器ID
+*/
+static ThreadPoolTimer TimerMakeId(const TimerNode *node)
+{
+    return ((ThreadPoolTimer)node->generation << 32) | (uint32_t)(node->index + 1);
+}
+
+/**
+* @brief      按编号查找节点
+* @note       调用者持有锁
+* @param[in]  wheel             定时轮指针
+* @param[in]  index             节点编号
+* @return     节点指针，不存在返回NULL
+*/
+static TimerNode *TimerLookup(TimerWheel *wheel, int index)
+{
+    int chunk = index / TIMER_CHUNK_SIZE;
+
+    if (index < 0 || chunk >= wheel->chunk_number) {
+        return NULL;
+    }
+    return &(wheel->chunks[chunk][index % TIMER_CHUNK_SIZE]);
+}
+
+/**
+* @brief      分配定时器节点
+* @note       调用者持有锁，空闲链表为空时追加一个节点块
+* @param[in]  wheel             定时轮指针
+* @return     节点指针，失败返回NULL
+*/
+static TimerNode *TimerNodeAlloc(TimerWheel *wheel)
+{
+    TimerNode *node, *chunk;
+    int i;
+
+    if (wheel->free_list == NULL) {
+        if (wheel->chunk_number >= MAX_TIMER_CHUNKS) {
+            return NULL;
+        }
+        chunk = (TimerNode *)calloc(TIMER_CHUNK_SIZE, sizeof(TimerNode));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        for (i = TIMER_CHUNK_SIZE - 1; i >= 0; i--) {
+            chunk[i].index = wheel->chunk_number * TIMER_CHUNK_SIZE + i;
+            chunk[i].next = wheel->free_list;
+            wheel->free_list = &chunk[i];
+        }
+        wheel->chunks[wheel->chunk_number++] = chunk;
+    }
+
+    node = wheel->free_list;
+    wheel->free_list = node->next;
+    node->prev = node->next = NULL;
+    node->list = NULL;
+    return node;
+}
+
+/**
+* @brief      释放定时器节点
+* @note       调用者持有锁，代数加一使旧ID失效
+* @param[in]  wheel             定时轮指针
+* @param[in]  node              定时器节点
+* @return     无
+*/
+static void TimerNodeFree(TimerWheel *wheel, TimerNode *node)
+{
+    node->state = TIMER_FREE;
+    node->generation++;
+    node->prev = NULL;
+    node->next = wheel->free_list;
+    wheel->free_list = node;
+}
+
+/**
+* @brief      节点挂入对应层的槽位
+* @note       调用者持有锁
+* @param[in]  wheel             定时轮指针
+* @param[in]  node              定时器节点
+* @return     无
+*/
+static void TimerInternalAdd(TimerWheel *wheel, TimerNode *node)
+{
+    uint64_t expires = node->expires;
+    uint64_t idx = expires - wheel->current;
+    TimerList *list;
+
+    if ((int64_t)idx < 0) {
+        /* 已过期，放到当前槽位 */
+        list = &(wheel->tv1[wheel->current & TVR_MASK]);
+    } else if (idx < TVR_SIZE) {
+        list = &(wheel->tv1[expires & TVR_MASK]);
+    } else if (idx < (1ULL << (TVR_BITS + TVN_BITS))) {
+        list = &(wheel->tv2[(expires >> TVR_BITS) & TVN_MASK]);
+    } else if (idx < (1ULL << (TVR_BITS + 2 * TVN_BITS))) {
+        list = &(wheel->tv3[(expires >> (TVR_BITS + TVN_BITS)) & TVN_MASK]);
+    } else {
+        list = &(wheel->tv4[(expires >> (TVR_BITS + 2 * TVN_BITS)) & TVN_MASK]);
+    }
+
+    node->prev = NULL;
+    node->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = node;
+    }
+    list->head = node;
+    node->list = list;
+    node->state = TIMER_PENDING;
+}
+
+/**
+* @brief      节点从槽位摘除
+* @note       调用者持有锁，双向链表O(1)摘除
+* @param[in]  node              定时器节点
+* @return     无
+*/
+static void TimerUnlink(TimerNode *node)
+{
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        node->list->head = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = NULL;
+    node->list = NULL;
+}
+
+/**
+* @brief      上层槽位下放
+* @note       调用者持有锁
+* @param[in]  wheel             定时轮指针
+* @param[in]  tv                层
+* @param[in]  index             槽位
+* @return     槽位编号，为0时需继续下放上一层
+*/
+static int TimerCascade(TimerWheel *wheel, TimerList *tv, int index)
+{
+    TimerNode *node = tv[index].head, *next;
+
+    tv[index].head = NULL;
+    while (node != NULL) {
+        next = node->next;
+        TimerInternalAdd(wheel, node);
+        node = next;
+    }
+    return index;
+}
+
+/**
+* @brief      推进一个刻度，收集到期节点
+* @note       调用者持有锁
+* @param[in]  wheel             定时轮指针
+* @param[out] expired           到期节点链表
+* @return     无
+*/
+static void TimerAdvance(TimerWheel *wheel, TimerNode **expired)
+{
+    int index = (int)(wheel->current & TVR_MASK);
+    TimerNode *node, *next;
+
+    if (!index &&
+        !TimerCascade(wheel, wheel->tv2, TIMER_INDEX(wheel, 0)) &&
+        !TimerCascade(wheel, wheel->tv3, TIMER_INDEX(wheel, 1))) {
+        TimerCascade(wheel, wheel->tv4, TIMER_INDEX(wheel, 2));
+    }
+    wheel->current++;
+
+    node = wheel->tv1[index].head;
+    wheel->tv1[index].head = NULL;
+    while (node != NULL) {
+        next = node->next;
+        node->state = TIMER_FIRING;
+        node->list = NULL;
+        node->prev = NULL;
+        node->next = *expired;
+        *expired = node;
+        wheel->count--;
+        node = next;
+    }
+}
+
+/**
+* @brief      刻度线程
+* @note       到期任务在解锁后批量提交线程池；线程池队列满时顺延一个刻度
+* @param[in]  arg               定时轮指针
+* @return     无
+*/
+static void *TimerWheelWork(void *arg)
+{
+    TimerWheel *wheel = (TimerWheel *)arg;
+    TimerNode *expired, *node, *batch[MAX_FIRE_BATCH];
+    int result[MAX_FIRE_BATCH];
+    uint64_t now, deadline;
+    struct timespec ts;
+    int i, n;
+
+    pthread_mutex_lock(&(wheel->lock));
+    while (!wheel->shutdown) {
+        now = (TimerNowMs() - wheel->start_ms) / wheel->tick_ms;
+
+        expired = NULL;
+        while (wheel->current <= now && wheel->count > 0) {
+            TimerAdvance(wheel, &expired);
+        }
+        if (wheel->count == 0 && wheel->current <= now) {
+            /* 轮上无定时器，直接对齐当前刻度 */
+            wheel->current = now + 1;
+        }
+
+        while (expired != NULL) {
+            n = 0;
+            while (expired != NULL && n < MAX_FIRE_BATCH) {
+                batch[n++] = expired;
+                expired = expired->next;
+            }
+
+            pthread_mutex_unlock(&(wheel->lock));
+            for (i = 0; i < n; i++) {
+                result[i] = ThreadPoolAppend(wheel->pool, batch[i]->func, batch[i]->arg);
+            }
+            pthread_mutex_lock(&(wheel->lock));
+
+            for (i = 0; i < n; i++) {
+                node = batch[i];
+                if (node->state == TIMER_CANCELLED) {
+                    TimerNodeFree(wheel, node);
+                } else if (result[i] == ThreadPoolQueueFull) {
+                    node->expires = wheel->current;
+                    TimerInternalAdd(wheel, node);
+                    wheel->count++;
+                } else if (node->period > 0 && result[i] == 0) {
+                    node->expires = wheel->current + node->period - 1;
+                    TimerInternalAdd(wheel, node);
+                    wheel->count++;
+                } else {
+                    TimerNodeFree(wheel, node);
+                }
+            }
+        }
+
+        if (wheel->shutdown) {
+            break;
+        }
+
+        if (wheel->count == 0) {
+            pthread_cond_wait(&(wheel->cond), &(wheel->lock));
+        } else {
+            deadline = wheel->start_ms + wheel->current * wheel->tick_ms;
+            ts.tv_sec = deadline / 1000;
+            ts.tv_nsec = (deadline % 1000) * 1000000;
+            pthread_cond_timedwait(&(wheel->cond), &(wheel->lock), &ts);
+        }
+    }
+    pthread_mutex_unlock(&(wheel->lock));
+
+    return NULL;
+}
+
+/**
+* @brief      取得线程池的定时轮
+* @note       在线程池锁内读取指针并增加引用，线程池关闭后返回NULL
+* @param[in]  pool              线程池指针
+* @return     TimerWheel*       定时轮指针，用完调用TimerWheelPut
+*/
+static TimerWheel *TimerWheelGet(ThreadPool *pool)
+{
+    TimerWheel *wheel = NULL;
+
+    if (pthread_mutex_lock(&(pool->lock)) != 0) {
+        return NULL;
+    }
+    if (!pool->shutdown && pool->timer_wheel != NULL) {
+        wheel = pool->timer_wheel;
+        __atomic_add_fetch(&(wheel->refs), 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&(pool->lock));
+    return wheel;
+}
+
+/**
+* @brief      释放定时轮引用
+* @note       最后一个引用释放时回收内存
+* @param[in]  wheel             定时轮指针
+* @return     无
+*/
+static void TimerWheelPut(TimerWheel *wheel)
+{
+    int i;
+
+    if (__atomic_sub_fetch(&(wheel->refs), 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    for (i = 0; i < wheel->chunk_number; i++) {
+        free(wheel->chunks[i]);
+    }
+    pthread_mutex_destroy(&(wheel->lock));
+    pthread_cond_destroy(&(wheel->cond));
+    free(wheel);
+}
+
+/**
+* @brief      销毁定时轮
+* @note       由ThreadPoolDestroy在摘下定时轮后通过函数指针调用，未执行的定时任务被丢弃；
+*             正在调度或取消的调用者仍持有引用，内存在它们返回后回收
+* @param[in]  wheel             定时轮指针
+* @return     无
+*/
+static void TimerWheelDestroy(TimerWheel *wheel)
+{
+    pthread_mutex_lock(&(wheel->lock));
+    wheel->shutdown = 1;
+    pthread_cond_signal(&(wheel->cond));
+    pthread_mutex_unlock(&(wheel->lock));
+
+    pthread_join(wheel->thread, NULL);
+    TimerWheelPut(wheel);
+}
+
+/**
+* @brief      为线程池创建定时轮
+* @note       可选，未调用时首次调度按TIMER_TICK_MS自动创建
+* @param[in]  pool              线程池指针
+* @param[in]  tick_ms           刻度毫秒数
+* @return     0                 成功
+* @return     其他              失败
+*/
+int ThreadPoolTimerCreate(ThreadPool *pool, unsigned int tick_ms)
+{
+    TimerWheel *wheel;
+    pthread_condattr_t attr;
+    int err = 0;
+
+    if (pool == NULL || tick_ms == 0) {
+        return ThreadPoolInvalid;
+    }
+
+    if (pthread_mutex_lock(&(pool->lock)) != 0) {
+        return ThreadPoolLockFailure;
+    }
+
+    do {
+        if (pool->shutdown) {
+            err = ThreadPoolShutDown;
+            break;
+        }
+        if (pool->timer_wheel != NULL) {
+            break;
+        }
+
+        if ((wheel = (TimerWheel *)calloc(1, sizeof(TimerWheel))) == NULL) {
+            err = ThreadPoolInvalid;
+            break;
+        }
+        wheel->pool = pool;
+        wheel->refs = 1;
+        wheel->tick_ms = tick_ms;
+        wheel->start_ms = TimerNowMs();
+
+        /* 条件变量使用单调时钟，不受系统时间调整影响 */
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        if ((pthread_mutex_init(&(wheel->lock), NULL) != 0) ||
+           (pthread_cond_init(&(wheel->cond), &attr) != 0)) {
+            pthread_condattr_destroy(&attr);
+            free(wheel);
+            err = ThreadPoolLockFailure;
+            break;
+        }
+        pthread_condattr_destroy(&attr);
+
+        if (pthread_create(&(wheel->thread), NULL, TimerWheelWork, (void *)wheel) != 0) {
+            pthread_mutex_destroy(&(wheel->lock));
+            pthread_cond_destroy(&(wheel->cond));
+            free(wheel);
+            err = ThreadPoolThreadFailure;
+            break;
+        }
+
+        pool->timer_wheel = wheel;
+        pool->timer_destroy = TimerWheelDestroy;
+    } while (0);
+
+    pthread_mutex_unlock(&(pool->lock));
+    return err;
+}
+
+/**
+* @brief      添加定时任务
+* @note
+* @param[in]  pool              线程池指针
+* @param[in]  delay_ms          首次延时毫秒数
+* @param[in]  period_ms         周期毫秒数，0表示单次
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     ThreadPoolTimer   定时器ID，失败返回0
+*/
+static ThreadPoolTimer TimerAdd(ThreadPool *pool, unsigned int delay_ms, unsigned int period_ms,
+                                void (*func)(void *), void *arg)
+{
+    TimerWheel *wheel;
+    TimerNode *node;
+    ThreadPoolTimer id;
+    uint64_t delay, now;
+
+    if (pool == NULL || func == NULL) {
+        return 0;
+    }
+
+    if ((wheel = TimerWheelGet(pool)) == NULL) {
+        if (ThreadPoolTimerCreate(pool, TIMER_TICK_MS) != 0 || (wheel = TimerWheelGet(pool)) == NULL) {
+            return 0;
+        }
+    }
+
+    pthread_mutex_lock(&(wheel->lock));
+    if (wheel->shutdown || (node = TimerNodeAlloc(wheel)) == NULL) {
+        pthread_mutex_unlock(&(wheel->lock));
+        TimerWheelPut(wheel);
+        return 0;
+    }
+
+    /* 向上取整到刻度，超出轮范围的截断到最大值 */
+    delay = (delay_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (delay > MAX_TIMER_TICKS) {
+        delay = MAX_TIMER_TICKS;
+    }
+    node->period = (period_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (period_ms > 0 && node->period == 0) {
+        node->period = 1;
+    }
+    if (node->period > MAX_TIMER_TICKS) {
+        node->period = MAX_TIMER_TICKS;
+    }
+
+    now = (TimerNowMs() - wheel->start_ms) / wheel->tick_ms;
+    if (wheel->count == 0) {
+        /* 空闲时刻度线程不推进current，直接对齐，避免逐个补走空闲期间的刻度 */
+        wheel->current = now;
+    } else if (now < wheel->current) {
+        now = wheel->current;
+    }
+    node->expires = now + delay;
+    node->func = func;
+    node->arg = arg;
+    TimerInternalAdd(wheel, node);
+    if (wheel->count++ == 0) {
+        pthread_cond_signal(&(wheel->cond));
+    }
+    id = TimerMakeId(node);
+    pthread_mutex_unlock(&(wheel->lock));
+    TimerWheelPut(wheel);
+
+    return id;
+}
+
+/**
+* @brief      延时执行任务
+* @note
+* @param[in]  pool              线程池指针
+* @param[in]  delay_ms          延时毫秒数
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     ThreadPoolTimer   定时器ID，失败返回0
+*/
+ThreadPoolTimer ThreadPoolSchedule(ThreadPool *pool, unsigned int delay_ms, void (*func)(void *), void *arg)
+{
+    return TimerAdd(pool, delay_ms, 0, func, arg);
+}
+
+/**
+* @brief      周期执行任务
+* @note       首次在delay_ms后执行，之后每period_ms执行一次，直到取消
+* @param[in]  pool              线程池指针
+* @param[in]  delay_ms          首次延时毫秒数
+* @param[in]  period_ms         周期毫秒数
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     ThreadPoolTimer   定时器ID，失败返回0
+*/
+ThreadPoolTimer ThreadPoolSchedulePeriodic(ThreadPool *pool, unsigned int delay_ms, unsigned int period_ms,
+                                           void (*func)(void *), void *arg)
+{
+    if (period_ms == 0) {
+        return 0;
+    }
+    return TimerAdd(pool, delay_ms, period_ms, func, arg);
+}
+
+/**
+* @brief      取消定时任务
+* @note       已提交到线程池的本次执行不受影响
+* @param[in]  pool              线程池指针
+* @param[in]  timer             定时器ID
+* @return     0                 成功
+* @return     其他              定时器不存在或已到期
+*/
+int ThreadPoolCancel(ThreadPool *pool, ThreadPoolTimer timer)
+{
+    TimerWheel *wheel;
+    TimerNode *node;
+    int err = 0;
+
+    if (pool == NULL || timer == 0 || (wheel = TimerWheelGet(pool)) == NULL) {
+        return ThreadPoolInvalid;
+    }
+
+    pthread_mutex_lock(&(wheel->lock));
+    node = TimerLookup(wheel, (int)(uint32_t)timer - 1);
+    if (node == NULL || node->generation != (uint32_t)(timer >> 32)) {
+        err = ThreadPoolInvalid;
+    } else if (node->state == TIMER_PENDING) {
+        TimerUnlink(node);
+        wheel->count--;
+        TimerNodeFree(wheel, node);
+    } else if (node->state == TIMER_FIRING) {
+        node->state = TIMER_CANCELLED;
+    } else {
+        err = ThreadPoolInvalid;
+    }
+    pthread_mutex_unlock(&(wheel->lock));
+    TimerWheelPut(wheel);
+
+    return err;
+}
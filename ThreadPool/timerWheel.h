@@ -0,0 +1,140 @@
+/**
+* @file      timerWheel.h
+* @brief     线程池定时轮头文件
+*
+* 分层时间轮，到期任务提交到线程池执行，插入和到期均为O(1)
+* @copyright http://www.avic-intl-sz.cn/
+* @author    xh
+* @version   1.0.0
+* @date      2026-10-19
+* @par history:
+* | version | date | author | description |
+* | ------- | ---- | ------ | ----------- |
+* | 1.0.0 | 2026-10-19 | xh | create |
+*/
+
+#ifndef __TIMERWHEEL_H_
+#define __TIMERWHEEL_H_
+
+#include <stdint.h>
+#include "threadPool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMER_TICK_MS       1           /* 默认时间刻度，毫秒 */
+#define TVR_BITS            8           /* 第一层槽位位数 */
+#define TVN_BITS            6           /* 其他层槽位位数 */
+#define TVR_SIZE            (1 << TVR_BITS)
+#define TVN_SIZE            (1 << TVN_BITS)
+#define TVR_MASK            (TVR_SIZE - 1)
+#define TVN_MASK            (TVN_SIZE - 1)
+#define MAX_TIMER_TICKS     ((1ULL << (TVR_BITS + 3 * TVN_BITS)) - 1)   /* 最大定时刻度数 */
+#define TIMER_CHUNK_SIZE    1024        /* 定时器节点按块分配 */
+#define MAX_TIMER_CHUNKS    64          /* 最多定时器块数 */
+
+/**
+* @brief           定时器ID，0为无效值
+*/
+typedef uint64_t ThreadPoolTimer;
+
+/**
+* @brief           槽位链表头
+*/
+typedef struct TimerList {
+    struct TimerNode *head;
+} TimerList;
+
+/**
+* @brief           定时器节点结构体
+*/
+typedef struct TimerNode {
+    struct TimerNode *prev;             /* 链表前驱 */
+    struct TimerNode *next;             /* 链表后继 */
+    TimerList *list;                    /* 所在槽位，取消时O(1)摘除 */
+    uint64_t expires;                   /* 到期刻度 */
+    uint64_t period;                    /* 周期刻度，0表示单次 */
+    void (*func)(void *);               /* 任务函数 */
+    void *arg;                          /* 传递功能参数 */
+    uint32_t generation;                /* 节点复用代数，用于识别过期ID */
+    int index;                          /* 节点编号 */
+    int state;                          /* 节点状态 */
+} TimerNode;
+
+/**
+* @brief           定时轮结构体
+*/
+typedef struct TimerWheel {
+    pthread_mutex_t lock;               /* 定时轮互斥锁 */
+    pthread_cond_t cond;                /* 刻度线程条件变量 */
+    pthread_t thread;                   /* 刻度线程 */
+    ThreadPool *pool;                   /* 执行到期任务的线程池 */
+    uint64_t current;                   /* 当前刻度 */
+    uint64_t start_ms;                  /* 起始单调时间 */
+    unsigned int tick_ms;               /* 刻度毫秒数 */
+    int count;                          /* 挂在轮上的定时器数 */
+    int shutdown;                       /* 停止标志 */
+    int refs;                           /* 引用数，线程池持有一个，调度和取消期间各持有一个 */
+    TimerList tv1[TVR_SIZE];            /* 第一层 */
+    TimerList tv2[TVN_SIZE];            /* 第二层 */
+    TimerList tv3[TVN_SIZE];            /* 第三层 */
+    TimerList tv4[TVN_SIZE];            /* 第四层 */
+    TimerNode *chunks[MAX_TIMER_CHUNKS];/* 节点块 */
+    int chunk_number;                   /* 已分配节点块数 */
+    TimerNode *free_list;               /* 空闲节点 */
+} TimerWheel;
+
+/**
+* @brief      为线程池创建定时轮
+* @note       可选，未调用时首次调度按TIMER_TICK_MS自动创建
+* @param[in]  pool              线程池指针
+* @param[in]  tick_ms           刻度毫秒数
+* @return     0                 成功
+* @return     其他              失败
+*/
+int
+ThreadPoolTimerCreate(ThreadPool *pool, unsigned int tick_ms);
+
+/**
+* @brief      延时执行任务
+* @note
+* @param[in]  pool              线程池指针
+* @param[in]  delay_ms          延时毫秒数
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     ThreadPoolTimer   定时器ID，失败返回0
+*/
+ThreadPoolTimer
+ThreadPoolSchedule(ThreadPool *pool, unsigned int delay_ms, void (*func)(void *), void *arg);
+
+/**
+* @brief      周期执行任务
+* @note       首次在delay_ms后执行，之后每period_ms执行一次，直到取消
+* @param[in]  pool              线程池指针
+* @param[in]  delay_ms          首次延时毫秒数
+* @param[in]  period_ms         周期毫秒数
+* @param[in]  func              任务函数
+* @param[in]  arg               函数参数
+* @return     ThreadPoolTimer   定时器ID，失败返回0
+*/
+ThreadPoolTimer
+ThreadPoolSchedulePeriodic(ThreadPool *pool, unsigned int delay_ms, unsigned int period_ms,
+                           void (*func)(void *), void *arg);
+
+/**
+* @brief      取消定时任务
+* @note       已提交到线程池的本次执行不受影响
+* @param[in]  pool              线程池指针
+* @param[in]  timer             定时器ID
+* @return     0                 成功
+* @return     其他              定时器不存在或已到期
+*/
+int
+ThreadPoolCancel(ThreadPool *pool, ThreadPoolTimer timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMERWHEEL_H_ */